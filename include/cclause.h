@@ -44,7 +44,7 @@ class CClause {
   void addLits(const Lit &, const Lit &);
   void addLits(const Lit &, const Lit &, const Lit &);
   void addLits(const std::vector<Lit> &);
-  std::vector<Lit> getLits() const;
+  const std::vector<Lit> &getLits() const;
   void clear();
   void printClause();
 };
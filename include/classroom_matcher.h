@@ -0,0 +1,56 @@
+/** @file */
+
+#ifndef CLASSROOM_MATCHER_H
+#define CLASSROOM_MATCHER_H
+
+#include <vector>
+#include "data.h"
+
+/**
+ * @brief      Class for assigning Classrooms to courses whose times are
+ * already fixed.
+ *
+ * The time atoms are visited in increasing order. The courses whose first
+ * time atom is the current one are matched to Classrooms with augmenting
+ * paths, where a Classroom is possible for a Course if it is in its domain
+ * and is not used by an already matched Course at any time atom of the
+ * Course. Matched courses keep their Classrooms, so a Course never shares a
+ * Classroom with a Course that it intersects in time. Each Course tries its
+ * preferred Classroom first, and then the other Classrooms from the smallest
+ * to the largest. This may fail even though an assignment exists, in which
+ * case the Classrooms have to be assigned by the solver.
+ */
+class ClassroomMatcher {
+ private:
+  /**
+   * A pointer to the Data object with the Classrooms and the domains
+   */
+  Data *data;
+  /**
+   * Stores the time atoms of each Course
+   */
+  std::vector<std::vector<unsigned>> courseAtoms;
+  /**
+   * Stores the Classrooms that each Course tries, in order
+   */
+  std::vector<std::vector<int>> candidates;
+  /**
+   * Stores, for every time atom, whether each Classroom is used by a matched
+   * Course
+   */
+  std::vector<std::vector<bool>> usedClassrooms;
+  /**
+   * Stores the Classroom assigned to each Course, or -1 if none is assigned
+   */
+  std::vector<int> assignment;
+  bool isFree(int, int);
+  bool augment(int, std::vector<int> &, std::vector<bool> &);
+
+ public:
+  ClassroomMatcher(Data *, const std::vector<int> &, const std::vector<int> &,
+                   const std::vector<int> &);
+  bool match();
+  int getClassroom(int);
+};
+
+#endif
@@ -0,0 +1,110 @@
+/** @file */
+
+#ifndef CLAUSE_SINK_H
+#define CLAUSE_SINK_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MaxSATFormula.h"
+#include "core/SolverTypes.h"
+#include "mtl/Vec.h"
+
+using namespace NSPACE;
+using namespace openwbo;
+
+/**
+ * @brief      Class for a destination of finished clauses.
+ *
+ * Clauses are given to a ClauseSink as soon as they are encoded, along with
+ * their weight, so that they do not have to be collected in intermediate
+ * containers. A negative weight implies that the clause is hard, and a zero
+ * weight implies that the clause is dropped.
+ */
+class ClauseSink {
+ public:
+  virtual ~ClauseSink() {}
+  /**
+   * @brief      Adds a clause with the given weight.
+   *
+   * @param[in]  lits    Pointer to the first literal of the clause
+   * @param[in]  size    The number of literals in the clause
+   * @param[in]  weight  The weight
+   */
+  virtual void addClause(const Lit *lits, unsigned size, int64_t weight) = 0;
+};
+
+/**
+ * @brief      Class for a ClauseSink that adds clauses to a MaxSATFormula.
+ */
+class FormulaClauseSink : public ClauseSink {
+ private:
+  /**
+   * A pointer to the MaxSAT formula object to which clauses are added
+   */
+  MaxSATFormula *formula;
+  /**
+   * Buffer reused for passing each clause to the formula
+   */
+  vec<Lit> buffer;
+
+ public:
+  FormulaClauseSink(MaxSATFormula *);
+  void addClause(const Lit *, unsigned, int64_t);
+};
+
+/**
+ * @brief      Class for a ClauseSink that writes clauses to a file in the
+ * WCNF format.
+ *
+ * The file is written in the headerless WCNF format, in which hard clauses
+ * start with "h" and soft clauses start with their weight, so that clauses can
+ * be written as they arrive, without knowing the number of variables and
+ * clauses in advance.
+ */
+class WCNFClauseSink : public ClauseSink {
+ private:
+  /**
+   * The stream to the file to which clauses are written
+   */
+  std::ofstream out;
+
+ public:
+  WCNFClauseSink(std::string);
+  void addClause(const Lit *, unsigned, int64_t);
+};
+
+/**
+ * @brief      Class for a ClauseSink that stores clauses in memory.
+ *
+ * The clauses are stored as a single pool of literals, along with the offset
+ * at which each clause starts and its weight, so that they can be added to
+ * another ClauseSink later.
+ */
+class BufferClauseSink : public ClauseSink {
+ private:
+  /**
+   * The literals of all the clauses, stored contiguously
+   */
+  std::vector<Lit> lits;
+  /**
+   * The offsets in lits at which each clause starts, followed by the total
+   * number of literals
+   */
+  std::vector<unsigned> offsets;
+  /**
+   * The weight of each clause
+   */
+  std::vector<int64_t> weights;
+
+ public:
+  BufferClauseSink();
+  void addClause(const Lit *, unsigned, int64_t);
+  unsigned size() const;
+  const Lit *getClause(unsigned) const;
+  unsigned getClauseSize(unsigned) const;
+  int64_t getWeight(unsigned) const;
+};
+
+#endif
@@ -5,33 +5,81 @@
 
 #include <vector>
 #include "cclause.h"
-#include "timetabler.h"
+#include "core/SolverTypes.h"
+#include "encoding_context.h"
 
 using namespace NSPACE;
 
 class CClause;
 
+/**
+ * @brief      Class for a read-only view of a clause stored in a Clauses
+ * object.
+ *
+ * The view refers to the literals in the literal pool of the Clauses object
+ * instead of copying them, and is invalidated when the Clauses object is
+ * modified or destroyed.
+ */
+class ClauseView {
+ private:
+  /**
+   * Pointer to the first literal of the clause
+   */
+  const Lit *first;
+  /**
+   * The number of literals in the clause
+   */
+  unsigned length;
+
+ public:
+  ClauseView(const Lit *first, unsigned length)
+      : first(first), length(length) {}
+  const Lit *begin() const { return first; }
+  const Lit *end() const { return first + length; }
+  unsigned size() const { return length; }
+  const Lit &operator[](unsigned i) const { return first[i]; }
+};
+
 /**
  * @brief      Class for representing a set of clauses.
  *
- * A set of clauses is represented as a vector of type CClause.
+ * A set of clauses is stored as a single pool of literals, in which the
+ * clauses are laid out one after the other, along with the offset at which
+ * each clause starts. This avoids a separate allocation for every clause.
  * This class defines operations between sets of clauses, such as
  * AND, OR, NOT, and IMPLIES. This also defines functions to
  * create Clauses, add clauses, and work with them. All clauses
- * are always maintained in the CNF form.
+ * are always maintained in the CNF form. The operations that need auxiliary
+ * variables create them in the EncodingContext of their operands, which is
+ * carried over to the result.
  */
 class Clauses {
  private:
   /**
-   * The clauses, each a CClause member object, in this set of Clauses
+   * The literals of all the clauses in this set of Clauses, stored
+   * contiguously
+   */
+  std::vector<Lit> lits;
+  /**
+   * The offsets in lits at which each clause starts, followed by the total
+   * number of literals. Clause i spans [offsets[i], offsets[i + 1]).
+   */
+  std::vector<unsigned> offsets = std::vector<unsigned>(1, 0);
+  /**
+   * A pointer to the EncodingContext in which auxiliary variables are
+   * created, or nullptr if none has been given
    */
-  std::vector<CClause> clauses;
+  EncodingContext *context = nullptr;
+  void addClause(const Lit *, unsigned);
+  EncodingContext *getContext(const Clauses &) const;
+  Lit getDefinition(EncodingContext *) const;
 
  public:
-  Clauses(const std::vector<CClause> &);
-  Clauses(const CClause &);
-  Clauses(const Lit &);
-  Clauses(const Var &);
+  Clauses(const std::vector<CClause> &, EncodingContext *context = nullptr);
+  Clauses(const CClause &, EncodingContext *context = nullptr);
+  Clauses(const Lit &, EncodingContext *context = nullptr);
+  Clauses(const Var &, EncodingContext *context = nullptr);
+  Clauses(EncodingContext *);
   Clauses();
   Clauses operator~();
   Clauses operator&(const Clauses &);
@@ -42,7 +90,10 @@ class Clauses {
   void addClauses(const CClause &);
   void addClauses(const std::vector<CClause> &);
   void addClauses(const Clauses &);
+  unsigned size() const;
+  ClauseView getClause(unsigned) const;
   std::vector<CClause> getClauses() const;
+  EncodingContext *getContext() const;
   void print();
   void clear();
 };
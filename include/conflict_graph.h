@@ -0,0 +1,44 @@
+/** @file */
+
+#ifndef CONFLICT_GRAPH_H
+#define CONFLICT_GRAPH_H
+
+#include <utility>
+#include <vector>
+#include "data.h"
+#include "global.h"
+
+/**
+ * @brief      Class for the conflict graph of courses.
+ *
+ * The conflict graph has an edge between a pair of courses for a FieldType if
+ * the two courses could be given a common field value of that FieldType at
+ * intersecting times. Only such pairs need a constraint that forbids them from
+ * sharing the field value at the same time. Field values that are ruled out
+ * by hard existing assignments, and Classrooms that are too small for a
+ * Course, are not considered possible for the Course. Edges are built for
+ * Instructors, Classrooms, and core Programs.
+ */
+class ConflictGraph {
+ private:
+  /**
+   * A pointer to the Data object from which the graph is built
+   */
+  Data *data;
+  /**
+   * Stores the edges for each FieldType as pairs of course indices, where the
+   * first index is smaller than the second
+   */
+  std::vector<std::vector<std::pair<unsigned, unsigned>>> edges;
+  std::vector<bool> getPossibleValues(int, FieldType);
+  std::vector<bool> getReachableValues(const std::vector<bool> &,
+                                       const std::vector<std::vector<bool>> &);
+  bool haveCommonValue(const std::vector<bool> &, const std::vector<bool> &);
+
+ public:
+  ConflictGraph(Data *);
+  void build();
+  const std::vector<std::pair<unsigned, unsigned>> &getEdges(FieldType);
+};
+
+#endif
@@ -3,7 +3,9 @@
 #ifndef CONSTRAINT_ADDER_H
 #define CONSTRAINT_ADDER_H
 
+#include <functional>
 #include "clauses.h"
+#include "conflict_graph.h"
 #include "constraint_encoder.h"
 #include "core/SolverTypes.h"
 #include "global.h"
@@ -35,20 +37,36 @@ class ConstraintAdder {
    * constraints to the solver
    */
   Timetabler *timetabler;
-  Clauses fieldSingleValueAtATime(FieldType);
-  std::vector<Clauses> exactlyOneFieldValuePerCourse(FieldType);
-  Clauses instructorSingleCourseAtATime();
-  Clauses classroomSingleCourseAtATime();
-  Clauses programSingleCoreCourseAtATime();
+  /**
+   * The conflict graph of the courses, used to constrain only the pairs of
+   * courses that could conflict
+   */
+  ConflictGraph conflictGraph;
+  void addPairConstraints(
+      FieldType, PredefinedClauses,
+      const std::function<Clauses(ConstraintEncoder *, unsigned, unsigned)> &);
+  void fieldSingleValueAtATime(FieldType, PredefinedClauses);
+  void fieldSingleValuePerTimeAtom(FieldType, PredefinedClauses);
+  void addOccupancyDefinitions();
+  void addSegmentOrderDefinitions();
+  std::vector<Clauses> exactlyOneFieldValuePerCourse(FieldType,
+                                                     PredefinedClauses);
+  void instructorSingleCourseAtATime();
+  void classroomSingleCourseAtATime();
+  void programSingleCoreCourseAtATime();
   std::vector<Clauses> minorInMinorTime();
   std::vector<Clauses> coreInMorningTime();
   std::vector<Clauses> electiveInNonMorningTime();
   // Clauses existingAssignmentClauses();
   std::vector<Clauses> programAtMostOneOfCoreOrElective();
+  void addGuardedConstraintClauses(PredefinedClauses, const Clauses &,
+                                   const int course);
+  void orderPhaseHints(FieldType, const std::vector<int> &);
 
  public:
   ConstraintAdder(ConstraintEncoder *, Timetabler *);
   void addConstraints();
+  void addSymmetryBreaking();
   void addSingleConstraint(PredefinedClauses, const Clauses &,
                            const int course);
 };
@@ -6,6 +6,7 @@
 #include <vector>
 #include "clauses.h"
 #include "core/SolverTypes.h"
+#include "encoding_context.h"
 #include "global.h"
 #include "timetabler.h"
 
@@ -26,25 +27,38 @@ using namespace NSPACE;
 class ConstraintEncoder {
  private:
   /**
-   * Stores a copy of all the variables in the form of the 3-tuple
-   * of (Course, FieldType, field value)
+   * A reference to the index of the variables of the Timetabler, in the form
+   * of the 3-tuple of (Course, FieldType, field value)
    */
-  std::vector<std::vector<std::vector<Var>>> vars;
+  const FieldValueIndex &index;
   /**
    * A pointer to a Timetabler object for accessing field data
    */
   Timetabler *timetabler;
+  /**
+   * A pointer to the EncodingContext of the Timetabler, in which all Clauses
+   * are created
+   */
+  EncodingContext *context;
   std::vector<Var> getAllowedVars(int, FieldType);
+  bool canHaveFieldValue(int, FieldType, int);
+  Clauses notIntersectingSegmentOrder(int, int);
 
  public:
   ConstraintEncoder(Timetabler *);
+  ConstraintEncoder(Timetabler *, EncodingContext *);
   Clauses hasSameFieldTypeAndValue(int, int, FieldType);
   Clauses hasSameFieldTypeNotSameValue(int, int, FieldType);
   Clauses notIntersectingTime(int, int);
   Clauses notIntersectingTimeField(int, int, FieldType);
-  Clauses hasExactlyOneFieldValueTrue(int, FieldType);
+  Clauses hasExactlyOneFieldValueTrue(int, FieldType,
+                                      bool onlyPositive = false);
   Clauses hasAtLeastOneFieldValueTrue(int, FieldType);
-  Clauses hasAtMostOneFieldValueTrue(int, FieldType);
+  Clauses hasAtMostOneFieldValueTrue(int, FieldType, bool onlyPositive = false);
+  Clauses atMostK(const std::vector<Lit> &, unsigned);
+  std::vector<Lit> getFieldValueLits(int, FieldType);
+  std::vector<Lit> getListedValueLits(const std::vector<int> &, FieldType,
+                                      const std::vector<int> &);
   Clauses hasCommonProgram(int, int);
   Clauses hasNoCommonCoreProgram(int, int);
   Clauses isMinorCourse(int);
@@ -54,6 +68,10 @@ class ConstraintEncoder {
   Clauses courseInMorningTime(int);
   Clauses programAtMostOneOfCoreOrElective(int);
   Clauses hasFieldTypeListedValues(int, FieldType, std::vector<int>);
+  Clauses occupiesTimeAtoms(int);
+  Clauses segmentOrderDefinitions(int);
+  Clauses valuePrecedence(FieldType, const std::vector<int> &);
+  Clauses fieldValueAtMostOneCourseInTimeAtom(FieldType, int, int);
 };
 
 #endif
@@ -32,6 +32,7 @@ struct Object {
   bool slotNotSame;
   bool courseExcept;
   int integer;
+  int bound;
   Timetabler *timetabler;
   ConstraintAdder *constraintAdder;
   ConstraintEncoder *constraintEncoder;
@@ -3,16 +3,20 @@
 #ifndef DATA_H
 #define DATA_H
 
+#include <chrono>
 #include <map>
 #include <string>
 #include <vector>
 #include "core/Solver.h"
+#include "domain_store.h"
+#include "field_value_index.h"
 #include "fields/classroom.h"
 #include "fields/course.h"
 #include "fields/instructor.h"
 #include "fields/program.h"
 #include "fields/segment.h"
 #include "fields/slot.h"
+#include "global.h"
 
 using namespace NSPACE;
 
@@ -59,18 +63,15 @@ class Data {
    */
   std::vector<IsMinor> isMinors;
   /**
-   * Stores the primary variables used in the solver.
-   * The variables are in a 3D vector form.
-   * They can be represented as a 3-tuple,
-   * (Course, FieldType, field value), where the first
-   * two dimensions represent the Course and the FieldType
-   * the variable represents, and the third dimension
-   * represents which field value of the given FieldType,
-   * out of the allowed field values, the variable
-   * corresponds to. These variables are added to the
-   * solver by the Parser.
+   * Stores the primary variables used in the solver, and the existing
+   * assignments given in the input, for every 3-tuple
+   * (Course, FieldType, field value). The variables are added to the
+   * solver by the Parser, and the variable of a field value that is
+   * forbidden by the domain store is var_Undef. If an existing assignment
+   * is given, the field value is assigned l_True or l_False, and otherwise,
+   * such as for a Classroom or a Slot that is not given, l_Undef.
    */
-  std::vector<std::vector<std::vector<Var>>> fieldValueVars;
+  FieldValueIndex fieldValueIndex;
   /**
    * Stores the high level variables. It is of the form
    * (Course, FieldType). If an assignment for a given
@@ -88,14 +89,18 @@ class Data {
    */
   std::vector<Var> customConstraintVars;
   /**
-   * Stores the existing assignments for every Course and
-   * FieldType as given in the input. This is of the form
-   * (Course, FieldType, field value), where if assigned true,
-   * the element is assigned l_True, and if false, is assigned
-   * l_False. If no assignment is given, such as for a
-   * Classroom or a Slot, the assigned value is l_Undef.
+   * Stores, for every Course and FieldType, the selector variable of the
+   * clauses of its existing assignment when solving in a session, or
+   * var_Undef if there is none. Assuming its negation lets the solver change
+   * the existing assignment, see Timetabler::assume.
    */
-  std::vector<std::vector<std::vector<lbool>>> existingAssignmentVars;
+  std::vector<std::vector<Var>> existingAssignmentSelectors;
+  /**
+   * Stores the field values that are fixed or forbidden for every Course.
+   * There is no variable for a forbidden value, and its variable in
+   * fieldValueIndex is var_Undef.
+   */
+  DomainStore domains;
   /**
    * Stores the weights for the high level variables of each
    * FieldType. This represents the weight that must be given to
@@ -126,6 +131,147 @@ class Data {
    * Stores the course with the associated custom constraint.
    */
   std::map<int, unsigned> customMap;
+  /**
+   * Stores whether each pair of Slots is intersecting, as a matrix indexed by
+   * the indices of the two Slots.
+   */
+  std::vector<std::vector<bool>> slotIntersections;
+  /**
+   * Stores whether each pair of Segments is intersecting, as a matrix indexed
+   * by the indices of the two Segments.
+   */
+  std::vector<std::vector<bool>> segmentIntersections;
+  /**
+   * Stores the encoding used for the constraints that forbid courses sharing
+   * an Instructor, a Classroom, or a core Program from having intersecting
+   * times.
+   */
+  TimeEncoding timeEncoding;
+  /**
+   * Stores the number of threads used for generating the constraints on
+   * pairs of courses, and for solving the independent components of the
+   * formula
+   */
+  unsigned threadCount;
+  /**
+   * Stores the encoding used for the constraint that a Course has at most one
+   * field value of a FieldType, where it is only required to hold
+   */
+  AMOEncoding amoEncoding;
+  /**
+   * Stores the configurations of the solvers that solve each component of
+   * the formula in parallel. The result of the first solver that finishes is
+   * used, and the others are stopped.
+   */
+  std::vector<SolverConfiguration> portfolio;
+  /**
+   * Stores the encoding used for the Segments of courses in the constraints
+   * that forbid courses from having intersecting times
+   */
+  SegmentEncoding segmentEncoding;
+  /**
+   * Stores whether a Course can only be assigned a Segment of the same length
+   * as the Segment it is given in the input, if any
+   */
+  bool keepSegmentLength;
+  /**
+   * Stores whether the constraints that break the symmetries between
+   * interchangeable Classrooms and Slots are added
+   */
+  bool symmetryBreaking;
+  /**
+   * Stores whether the clauses of hard predefined and custom constraints are
+   * added without their selector variables, in which case a failure cannot be
+   * explained
+   */
+  bool directHardConstraints;
+  /**
+   * Stores whether the selector variables of hard predefined and custom
+   * constraints are soft, so that the constraints that cannot be satisfied
+   * can be found
+   */
+  bool relaxHardConstraints;
+  /**
+   * Stores whether the Timetabler is kept to be solved again under different
+   * assumptions, see Timetabler::assume. The hard constraints and the
+   * existing assignments then have selector variables that are assumed by
+   * default, and field values are not removed for hard existing assignments,
+   * so that all of them can be changed by assumptions.
+   */
+  bool session;
+  /**
+   * Stores whether the Classrooms are assigned by a ClassroomMatcher after
+   * solving, instead of the formula constraining a Classroom to be used by at
+   * most one Course at a time
+   */
+  bool matchClassrooms;
+  /**
+   * Stores whether any custom constraint involves Classrooms, which a
+   * ClassroomMatcher cannot take into account
+   */
+  bool customClassroomConstraints;
+  /**
+   * Stores the time at which solving is stopped, with the best timetable
+   * found so far being kept
+   */
+  std::chrono::steady_clock::time_point deadline;
+  /**
+   * Stores the literals of a previous timetable, which the solver tries
+   * first when it makes decisions
+   */
+  std::vector<Lit> phaseHints;
+  /**
+   * Stores the file descriptor to which the progress of the solvers is
+   * written as JSON lines, or -1 if it is not written
+   */
+  int progressFd;
+  /**
+   * Stores, for every FieldType, whether each field value is listed by a
+   * custom constraint, in which case it is not interchangeable with other
+   * field values
+   */
+  std::vector<std::vector<bool>> listedValues;
+  /**
+   * Stores the number of time periods. A time period is a maximal interval of
+   * a Day that no SlotElement starts or ends inside of, such that every Slot
+   * either covers it completely or not at all.
+   */
+  unsigned periodCount;
+  /**
+   * Stores the number of segment units, which are the individual segment IDs
+   * that a Segment can span.
+   */
+  unsigned segmentUnitCount;
+  /**
+   * Stores, for every Slot, the indices of the time periods it covers.
+   */
+  std::vector<std::vector<unsigned>> slotPeriods;
+  /**
+   * Stores, for every Segment, the indices of the segment units it covers.
+   */
+  std::vector<std::vector<unsigned>> segmentUnits;
+  /**
+   * Stores the occupancy variables used in the solver when the occupancy
+   * time encoding is used. They are of the form (Course, time atom), where a
+   * time atom is a pair of a time period and a segment unit, with index
+   * period * segmentUnitCount + unit. If a Course is scheduled at a time
+   * which covers the time atom, the variable is forced to be True.
+   */
+  std::vector<std::vector<Var>> occupancyVars;
+  /**
+   * Stores the order variables for the start of the Segment of every Course,
+   * used when the order segment encoding is used. The variable at index k is
+   * True if the Segment starts after the segment unit k, for k from 0 to
+   * segmentUnitCount - 2.
+   */
+  std::vector<std::vector<Var>> segmentStartVars;
+  /**
+   * Stores the order variables for the end of the Segment of every Course,
+   * used when the order segment encoding is used. The variable at index k is
+   * True if the Segment ends after the segment unit k, for k from 0 to
+   * segmentUnitCount - 2.
+   */
+  std::vector<std::vector<Var>> segmentEndVars;
   Data();
 };
 
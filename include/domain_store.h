@@ -0,0 +1,37 @@
+/** @file */
+
+#ifndef DOMAIN_STORE_H
+#define DOMAIN_STORE_H
+
+#include <vector>
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Class for the domains of the fields of every Course.
+ *
+ * For every (Course, FieldType, field value), this records whether the value
+ * is fixed to True (l_True), forbidden (l_False), or free (l_Undef). It is
+ * filled after parsing from the information that holds in every solution,
+ * such as hard existing assignments and the sizes of the classrooms. No
+ * variable is created for a forbidden value, and such values are skipped when
+ * encoding constraints. Values that have not been recorded are free.
+ */
+class DomainStore {
+ private:
+  /**
+   * Stores the state of every (Course, FieldType, field value)
+   */
+  std::vector<std::vector<std::vector<lbool>>> values;
+
+ public:
+  void clear();
+  void setValue(int, FieldType, int, lbool);
+  lbool getValue(int, FieldType, int) const;
+  bool isForbidden(int, FieldType, int) const;
+  bool isFixed(int, FieldType, int) const;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/** @file */
+
+#ifndef ENCODING_CONTEXT_H
+#define ENCODING_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "clause_sink.h"
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+class Clauses;
+
+/**
+ * @brief      Hash function for a vector of literals, used for looking up
+ * cached definitions.
+ */
+struct LitVectorHash {
+  std::size_t operator()(const std::vector<Lit> &) const;
+};
+
+/**
+ * @brief      Struct for the definition of an auxiliary variable as a
+ * conjunction or a disjunction of literals.
+ *
+ * The definitions form a DAG over the literals, built by the operations on
+ * Clauses. The clauses of each direction of a definition are added to the
+ * formula only when needed.
+ */
+struct Definition {
+  /**
+   * Whether the variable is defined as the conjunction of the literals,
+   * instead of their disjunction
+   */
+  bool isConjunction;
+  /**
+   * The literals in the definition
+   */
+  std::vector<Lit> lits;
+  /**
+   * Whether the clauses for (variable -> definition) have been added
+   */
+  bool positiveAdded;
+  /**
+   * Whether the clauses for (definition -> variable) have been added
+   */
+  bool negativeAdded;
+};
+
+/**
+ * @brief      Class for the state needed to encode a problem.
+ *
+ * This holds the allocator for variables, the ClauseSink to which the
+ * clauses are added, and the definitions of the auxiliary variables created
+ * by the operations on Clauses. Clauses carry a pointer to the
+ * EncodingContext in which they are encoded, so that several problems can be
+ * encoded in the same process, each with its own EncodingContext, possibly
+ * on different threads. An EncodingContext must not be shared between
+ * threads.
+ *
+ * It also gives the cardinality constraints, whose encodings only need
+ * auxiliary variables, see atMostK.
+ *
+ * An EncodingContext can also issue variables starting from a given
+ * variable, so that a worker can encode part of a problem in its own
+ * EncodingContext, whose clauses are then added to the main one with their
+ * variables renumbered.
+ */
+class EncodingContext {
+ private:
+  /**
+   * The variable to be issued next
+   */
+  Var vars;
+  /**
+   * A pointer to the ClauseSink to which all clauses are added
+   */
+  ClauseSink *sink;
+  /**
+   * Stores the definition literal of every clause that has been defined,
+   * keyed on its sorted literals
+   */
+  std::unordered_map<std::vector<Lit>, Lit, LitVectorHash> clauseDefinitions;
+  /**
+   * Stores the definition literal of every conjunction of literals that has
+   * been defined, keyed on its sorted literals
+   */
+  std::unordered_map<std::vector<Lit>, Lit, LitVectorHash>
+      conjunctionDefinitions;
+  /**
+   * Stores the definitions of the auxiliary variables
+   */
+  std::vector<Definition> definitions;
+  /**
+   * Stores, for every variable, the index of its definition in definitions,
+   * or -1 if it is not defined
+   */
+  std::vector<int> definitionIndex;
+  /**
+   * Buffer reused for building clauses with an added guard literal, or with
+   * renumbered variables
+   */
+  std::vector<Lit> clauseBuffer;
+  /**
+   * The total weight of the soft clauses added so far
+   */
+  uint64_t softWeight;
+  Lit addDefinition(bool, const std::vector<Lit> &);
+  void addDefinitionPolarity(Lit);
+  Clauses atMostOneBinomial(const std::vector<Lit> &);
+  Clauses atMostOneSequential(const std::vector<Lit> &);
+  Clauses atMostOneProduct(const std::vector<Lit> &);
+  std::vector<Lit> totalizer(const std::vector<Lit> &, unsigned, unsigned,
+                             unsigned, Clauses &);
+
+ public:
+  EncodingContext(ClauseSink *, Var firstVar = 0);
+  ~EncodingContext();
+  void setClauseSink(ClauseSink *);
+  Var newVar();
+  Lit newLiteral(bool sign = false);
+  int nVars() const;
+  Lit defineClause(const Lit *, unsigned);
+  Lit defineConjunction(std::vector<Lit>);
+  void addClause(const Lit *, unsigned, int64_t);
+  void addGuardedClauses(const Var &, const Clauses &, int);
+  void addBufferedClauses(const BufferClauseSink &, Var, Var);
+  Clauses atMostK(const std::vector<Lit> &, unsigned, AMOEncoding);
+  uint64_t getSoftWeight() const;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/** @file */
+
+#ifndef FIELD_VALUE_INDEX_H
+#define FIELD_VALUE_INDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Class for the variables and the existing assignments of every
+ * (Course, FieldType, field value).
+ *
+ * The entries of all courses are stored in a single flat array, where the
+ * entries of a Course form a block of stride entries, in which the entries of
+ * each FieldType start at its offset. Every Course has the same number of
+ * field values of a FieldType. The existing assignments are packed into two
+ * bits per entry. This is shared by reference by everything that needs to
+ * look up the variable of a field value.
+ */
+class FieldValueIndex {
+ private:
+  /**
+   * Stores the number of field values of each FieldType
+   */
+  std::vector<unsigned> valueCounts;
+  /**
+   * Stores the offset of the entries of each FieldType in the block of a
+   * Course
+   */
+  std::vector<unsigned> fieldOffsets;
+  /**
+   * The number of entries in the block of a Course
+   */
+  unsigned stride;
+  /**
+   * The number of courses
+   */
+  unsigned courseCount;
+  /**
+   * Stores the variable of every entry, or var_Undef if there is none
+   */
+  std::vector<Var> vars;
+  /**
+   * Stores the existing assignment of every entry in two bits, which are 0
+   * for l_Undef, 1 for l_True, and 2 for l_False
+   */
+  std::vector<uint64_t> existingAssignments;
+
+  /**
+   * @brief      Gets the position of an entry in the flat array.
+   *
+   * @param[in]  course     The course
+   * @param[in]  fieldType  The field type
+   * @param[in]  value      The index of the field value
+   *
+   * @return     The position of the entry
+   */
+  unsigned position(int course, FieldType fieldType, int value) const {
+    return course * stride + fieldOffsets[fieldType] + value;
+  }
+
+ public:
+  FieldValueIndex();
+  void init(const std::vector<unsigned> &);
+  int addCourse();
+  unsigned getCourseCount() const;
+  unsigned getValueCount(FieldType) const;
+  void setVar(int, FieldType, int, Var);
+  void setExistingAssignment(int, FieldType, int, lbool);
+
+  /**
+   * @brief      Gets the variable of a field value of a Course.
+   *
+   * @param[in]  course     The course
+   * @param[in]  fieldType  The field type
+   * @param[in]  value      The index of the field value
+   *
+   * @return     The variable, or var_Undef if the value has no variable
+   */
+  Var getVar(int course, FieldType fieldType, int value) const {
+    return vars[position(course, fieldType, value)];
+  }
+
+  /**
+   * @brief      Gets the existing assignment of a field value of a Course.
+   *
+   * @param[in]  course     The course
+   * @param[in]  fieldType  The field type
+   * @param[in]  value      The index of the field value
+   *
+   * @return     The existing assignment, which is l_Undef if there is none
+   */
+  lbool getExistingAssignment(int course, FieldType fieldType,
+                              int value) const {
+    unsigned entry = position(course, fieldType, value);
+    unsigned shift = 2 * (entry % 32);
+    unsigned bits = (existingAssignments[entry / 32] >> shift) & 3;
+    return (bits == 0) ? l_Undef : ((bits == 1) ? l_True : l_False);
+  }
+};
+
+#endif
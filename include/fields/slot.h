@@ -48,6 +48,7 @@ class Time {
   bool operator>=(const Time &);
   bool operator>(const Time &);
   std::string getTimeString();
+  unsigned getMinutesFromMidnight();
   bool isMorningTime();
 };
 
@@ -71,6 +72,9 @@ class SlotElement {
   SlotElement(Time &, Time &, Day);
   bool isIntersecting(SlotElement &other);
   bool isMorningSlotElement();
+  Day getDay();
+  Time getStartTime();
+  Time getEndTime();
 };
 
 /**
@@ -100,6 +104,7 @@ class Slot : public Field {
   bool operator==(const Slot &other);
   bool isIntersecting(Slot &other);
   void addSlotElements(SlotElement);
+  std::vector<SlotElement> getSlotElements();
   bool isMinorSlot();
   FieldType getType();
   std::string getTypeName();
@@ -0,0 +1,60 @@
+/** @file */
+
+#ifndef FORMULA_COMPONENTS_H
+#define FORMULA_COMPONENTS_H
+
+#include <vector>
+#include "clause_sink.h"
+#include "core/SolverTypes.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Class for the independent components of a formula.
+ *
+ * Two clauses are in the same component if they are connected through
+ * clauses that share variables. The components can be solved separately, as
+ * no clause constrains the variables of two components, and the sum of the
+ * optimal costs of the components is the optimal cost of the formula. As the
+ * components are found from the clauses, they account for everything that
+ * couples courses, such as shared Instructors, Programs and Classrooms, and
+ * custom constraints.
+ *
+ * As each component is solved by its own solver, which has a fixed cost,
+ * components with few variables are merged into a single component. The
+ * clauses can also be kept in a single component, for example to solve them
+ * with several solvers in parallel without decomposing them.
+ */
+class FormulaComponents {
+ private:
+  /**
+   * The number of variables below which components are merged
+   */
+  static const int MIN_VAR_COUNT = 32;
+  /**
+   * Stores the parent of every variable in the disjoint set forest
+   */
+  std::vector<Var> parents;
+  /**
+   * Stores the index of every variable among the variables of its component
+   */
+  std::vector<Var> localVars;
+  /**
+   * Stores the indices of the clauses of each component
+   */
+  std::vector<std::vector<unsigned>> clauses;
+  /**
+   * Stores the variables of each component, in increasing order
+   */
+  std::vector<std::vector<Var>> vars;
+  Var find(Var);
+
+ public:
+  FormulaComponents(const BufferClauseSink &, int, bool split = true);
+  unsigned size() const;
+  const std::vector<unsigned> &getClauses(unsigned) const;
+  const std::vector<Var> &getVars(unsigned) const;
+  Var getLocalVar(Var) const;
+};
+
+#endif
@@ -26,6 +26,86 @@ enum PredefinedClauses {
   programAtMostOneOfCoreOrElective
 };
 
+/**
+ * @brief      Enum that represents the ways in which the constraints that
+ * forbid two courses from sharing a time are encoded.
+ */
+enum class TimeEncoding {
+  /**
+   * Every pair of courses gets a constraint that their times do not intersect
+   */
+  pairwise,
+  /**
+   * Every course gets a variable for each time atom it occupies, and at most
+   * one course may occupy a time atom for a given field value
+   */
+  occupancy
+};
+
+/**
+ * @brief      Enum that represents the ways in which the Segment of a Course
+ * is encoded in the constraints that its time does not intersect the time of
+ * another Course, when the pairwise time encoding is used.
+ */
+enum class SegmentEncoding {
+  /**
+   * Two Segments are compared through the variables of all the pairs of
+   * intersecting Segments
+   */
+  interval,
+  /**
+   * Every Course gets order variables for the start and the end of its
+   * Segment, and two Segments are compared through the order variables of
+   * the segment units. This also makes the constraint that a Course has at
+   * most one Segment hard.
+   */
+  order
+};
+
+/**
+ * @brief      Enum that represents the ways in which the constraint that a
+ * Course has at most one field value of a FieldType is encoded, when the
+ * constraint only has to hold, and is never negated.
+ */
+enum class AMOEncoding {
+  /**
+   * Every pair of field values gets a clause that they are not both True
+   */
+  binomial,
+  /**
+   * The sequential counter encoding, with a linear number of clauses and
+   * auxiliary variables
+   */
+  sequential,
+  /**
+   * The product encoding, which arranges the field values in a grid and
+   * constrains its rows and columns recursively
+   */
+  product
+};
+
+/**
+ * @brief      Enum that represents the configurations of the solvers that
+ * solve the formula in parallel.
+ */
+enum class SolverConfiguration {
+  /**
+   * The OLL algorithm with stratification, which first considers only the
+   * soft clauses with the largest weights
+   */
+  stratified,
+  /**
+   * The OLL algorithm without stratification, which considers all soft
+   * clauses from the start
+   */
+  unstratified,
+  /**
+   * The OLL algorithm with stratification, where the SAT solver makes some
+   * random decisions with a seed that differs between solvers
+   */
+  randomized
+};
+
 /**
  * @brief      Class for global values.
  */
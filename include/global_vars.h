@@ -1,13 +0,0 @@
-/** @file */
-
-#ifndef GLOBAL_VARS_H
-#define GLOBAL_VARS_H
-
-#include "timetabler.h"
-
-/**
- * Timetabler variable
- */
-extern Timetabler *timetabler;
-
-#endif
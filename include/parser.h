@@ -21,11 +21,17 @@ class Parser {
    */
   Timetabler *timetabler;
   Day getDayFromString(std::string);
+  void computeTimeAtoms();
+  void computeIntersections();
+  void addPhaseHints(int, FieldType, int);
+  void addPhaseHint(int, FieldType, int, bool);
 
  public:
   Parser(Timetabler *);
   void parseFields(std::string file);
   void parseInput(std::string file);
+  void parseWarmStart(std::string file);
+  void reduceDomains();
   void addVars();
   bool verify();
 };
@@ -0,0 +1,39 @@
+/** @file */
+
+#ifndef SYMMETRY_DETECTOR_H
+#define SYMMETRY_DETECTOR_H
+
+#include <vector>
+#include "data.h"
+#include "global.h"
+
+/**
+ * @brief      Class for finding the field values that are interchangeable.
+ *
+ * Two field values are interchangeable if swapping them in every solution
+ * gives another solution with the same cost. This is the case for Classrooms
+ * of the same size, and for Slots that cover the same time periods and agree
+ * on being minor and morning Slots, as long as every Course has the same
+ * existing assignment and domain for both, and no custom constraint lists
+ * either of them. Interchangeable values are found for Classrooms and Slots.
+ */
+class SymmetryDetector {
+ private:
+  /**
+   * A pointer to the Data object in which the symmetries are found
+   */
+  Data *data;
+  /**
+   * Stores, for each FieldType, the classes of interchangeable field values
+   */
+  std::vector<std::vector<std::vector<int>>> classes;
+  bool haveSameProperties(FieldType, int, int);
+  bool haveSameAssignments(FieldType, int, int);
+
+ public:
+  SymmetryDetector(Data *);
+  void detect();
+  const std::vector<std::vector<int>> &getClasses(FieldType);
+};
+
+#endif
@@ -3,11 +3,16 @@
 #ifndef TIMETABLER_H
 #define TIMETABLER_H
 
+#include <cstdint>
+#include <mutex>
 #include <vector>
 #include "MaxSATFormula.h"
 #include "cclause.h"
+#include "clause_sink.h"
 #include "core/SolverTypes.h"
 #include "data.h"
+#include "encoding_context.h"
+#include "formula_components.h"
 #include "mtl/Vec.h"
 #include "tsolver.h"
 
@@ -28,7 +33,11 @@ enum SolverStatus {
   /**
    * Some hard clauses could not be satisfied
    */
-  Unsolved
+  Unsolved,
+  /**
+   * The deadline was reached before any timetable was found
+   */
+  TimedOut
 };
 
 /**
@@ -51,10 +60,86 @@ class Timetabler {
    * A pointer to the MaxSAT formula object
    */
   MaxSATFormula *formula;
+  /**
+   * A pointer to the EncodingContext in which the problem is encoded
+   */
+  EncodingContext *context;
+  /**
+   * A pointer to the buffer to which all clauses are added if the components
+   * of the formula are solved separately, or nullptr otherwise
+   */
+  BufferClauseSink *clauseBuffer;
+  /**
+   * Stores whether the buffered formula is split into its independent
+   * components
+   */
+  bool splitComponents;
+  /**
+   * A pointer to the components of the buffered formula, which are found in
+   * the first call of solve(), or nullptr before that
+   */
+  FormulaComponents *components;
+  /**
+   * Stores the solvers of Data::portfolio for each component of the buffered
+   * formula, which are kept between calls of solve()
+   */
+  std::vector<std::vector<TSolver *>> componentSolvers;
+  /**
+   * Stores whether the formula has been loaded into the solver
+   */
+  bool formulaLoaded;
+  /**
+   * Stores the literals that are assumed to be True when solving
+   */
+  std::vector<Lit> assumptions;
+  /**
+   * Stores the selector literals of the hard constraints whose unit clauses
+   * are added by addRelaxedHardClauses(), see Data::relaxHardConstraints
+   */
+  std::vector<Lit> relaxedSelectors;
+  /**
+   * Stores the selector literals that solve() assumes by default when
+   * Data::session is set
+   */
+  std::vector<Lit> sessionAssumptions;
+  /**
+   * Stores the selector variables of the clauses that break symmetries when
+   * Data::session is set
+   */
+  std::vector<Var> symmetrySelectors;
+  /**
+   * Guards the file descriptor to which the progress of the solvers is
+   * written
+   */
+  std::mutex progressMutex;
   /**
    * Stores the values of each solver variable to be checked after solving
    */
   std::vector<lbool> model;
+  /**
+   * Stores the cost of the model
+   */
+  uint64_t cost;
+  /**
+   * Stores whether solving was interrupted at Data::deadline
+   */
+  bool timedOut;
+  /**
+   * Stores whether assignClassrooms() raised the cost of the model above the
+   * cost found by the solver
+   */
+  bool matchingRaisedCost;
+  std::vector<lbool> solveComponents();
+  std::vector<lbool> solveComponent(unsigned, const std::vector<Lit> &,
+                                    uint64_t &, bool &);
+  MaxSATFormula *getComponentFormula(const FormulaComponents &, unsigned);
+  std::vector<Lit> getComponentLits(const FormulaComponents &, unsigned,
+                                    const std::vector<Lit> &);
+  void configureSolver(TSolver *, unsigned);
+  void writeProgress(unsigned, unsigned, const SolverProgress &);
+  void addSelectorClause(Lit, int);
+  std::vector<Lit> getSearchAssumptions();
+  uint64_t getExistingAssignmentCost(FieldType);
 
  public:
   /**
@@ -65,10 +150,24 @@ class Timetabler {
   ~Timetabler();
   void addClauses(const std::vector<CClause> &, int);
   void addClauses(const Clauses &, int);
+  void addGuardedClauses(const Var &, const Clauses &, int);
+  void addCardinality(const std::vector<Lit> &, unsigned, const Var &, int);
+  Var getGuard(const Var &, int);
+  Var newSymmetrySelector();
+  bool matchesClassrooms();
+  bool assignClassrooms();
+  void setClauseSink(ClauseSink *);
+  void bufferClauses(bool split = true);
+  EncodingContext *getEncodingContext();
   bool checkAllTrue(const std::vector<Var> &);
   bool checkAllTrue(const std::vector<std::vector<Var>> &);
   bool isVarTrue(const Var &);
+  void assume(Lit);
+  void retract(Var);
+  void clearAssumptions();
   SolverStatus solve();
+  bool isOptimal();
+  uint64_t getCost();
   Var newVar();
   Lit newLiteral(bool sign = false);
   void printResult(SolverStatus);
@@ -79,8 +178,10 @@ class Timetabler {
   void addHighLevelCustomConstraintClauses(int, int);
   void writeOutput(std::string);
   void addExistingAssignments();
+  void addRelaxedHardClauses();
   void addToFormula(vec<Lit> &, int);
   void addToFormula(Lit, int);
+  void addToFormula(const Lit *, unsigned, int);
   void displayChangesInGivenAssignment();
 };
 
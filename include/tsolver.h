@@ -3,6 +3,11 @@
 #ifndef TSOLVER_H
 #define TSOLVER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include "MaxSAT.h"
 #include "algorithms/Alg_OLL.h"
@@ -11,6 +16,48 @@
 using namespace NSPACE;
 using namespace openwbo;
 
+/**
+ * @brief      Struct for the progress of a search of a TSolver.
+ */
+struct SolverProgress {
+  /**
+   * The time since the search started, in seconds
+   */
+  double elapsed;
+  /**
+   * The lower bound of the cost
+   */
+  uint64_t lowerBound;
+  /**
+   * The cost of the best model found so far, or UINT64_MAX if there is none
+   */
+  uint64_t upperBound;
+  /**
+   * The number of cores found
+   */
+  int cores;
+  /**
+   * The average number of literals in a core
+   */
+  double averageCoreSize;
+  /**
+   * The smallest weight of the soft clauses that are considered
+   */
+  uint64_t minWeight;
+  /**
+   * The number of calls of the SAT solver
+   */
+  unsigned satCalls;
+  /**
+   * The memory used by the process, in megabytes
+   */
+  double memory;
+  /**
+   * Whether the search has returned
+   */
+  bool finished;
+};
+
 /**
  * @brief      Class for solver.
  *
@@ -21,12 +68,98 @@ using namespace openwbo;
  * the output to stdout and exit, instead, it returns the model.
  * tWeighted() also does not print to stdout, when the solver
  * terminates, it simply returns.
+ *
+ * The search can be given a deadline, at which the SAT solver is interrupted
+ * and the best model found so far is returned. It can also be interrupted
+ * from another thread, and configured differently so that several solvers
+ * can solve the same formula in parallel.
+ *
+ * The search can be repeated with different assumptions. The SAT solver and
+ * its learned clauses are kept between searches, while the cores, which may
+ * depend on the assumptions, are found again. The formula must not be
+ * changed after the first search.
  */
 class TSolver : public OLL {
+ private:
+  /**
+   * The frequency of random decisions of the SAT solver when it has a random
+   * seed
+   */
+  static constexpr double RANDOM_VAR_FREQ = 0.02;
+  /**
+   * The time at which the search is interrupted
+   */
+  std::chrono::steady_clock::time_point deadline;
+  /**
+   * Set when the deadline is reached or the search is interrupted
+   */
+  std::atomic<bool> interrupted;
+  /**
+   * Stores whether the soft clauses are considered in decreasing order of
+   * their weights
+   */
+  bool stratification;
+  /**
+   * The random seed of the SAT solver, or 0 if it makes no random decisions
+   */
+  double randomSeed;
+  /**
+   * Stores whether the last search was interrupted before it finished
+   */
+  bool timedOut;
+  /**
+   * Guards the SAT solver while it is being interrupted
+   */
+  std::mutex solverMutex;
+  /**
+   * Stores the literals that are assumed to be True in every call of the SAT
+   * solver during the search
+   */
+  vec<Lit> searchAssumptions;
+  /**
+   * Stores the literals that the SAT solver tries first when it makes
+   * decisions
+   */
+  std::vector<Lit> phases;
+  /**
+   * The function that is called with the progress of the search before
+   * every call of the SAT solver, and when the search returns
+   */
+  std::function<void(const SolverProgress &)> progressCallback;
+  /**
+   * The time at which the current search started
+   */
+  std::chrono::steady_clock::time_point searchStart;
+  /**
+   * The number of calls of the SAT solver in the current search
+   */
+  unsigned satCalls;
+  void reportProgress(bool);
+  /**
+   * A pointer to the formula that was loaded before the first search
+   */
+  MaxSATFormula *loadedFormula;
+  /**
+   * Stores the weights of the soft clauses of the loaded formula, before the
+   * first search changed them
+   */
+  std::vector<uint64_t> softWeights;
+  void restoreFormula();
+
  public:
   TSolver(int verb = _VERBOSITY_MINIMAL_, int enc = _CARD_TOTALIZER_);
-  std::vector<lbool> tSearch();
+  ~TSolver();
+  void setDeadline(std::chrono::steady_clock::time_point);
+  void setStratification(bool);
+  void setRandomSeed(double);
+  void setPhases(const std::vector<Lit> &);
+  void setProgressCallback(std::function<void(const SolverProgress &)>);
+  void interrupt();
+  std::vector<lbool> tSearch(
+      const std::vector<Lit> &assumptions = std::vector<Lit>());
   void tWeighted();
+  bool hasTimedOut();
+  uint64_t getCost();
 };
 
 #endif
@@ -93,7 +93,7 @@ std::vector<CClause> CClause::operator&(const CClause &other) {
  * @return     A Clauses object with the result of performing the AND operation
  */
 Clauses CClause::operator&(const Clauses &other) {
-  Clauses result(other.getClauses());
+  Clauses result(other);
   result.addClauses(*this);
   return result;
 }
@@ -112,8 +112,9 @@ Clauses CClause::operator&(const Clauses &other) {
  */
 CClause CClause::operator|(const CClause &other) {
   std::vector<Lit> thisLits = this->lits;
-  std::vector<Lit> otherLits = other.getLits();
+  const std::vector<Lit> &otherLits = other.getLits();
   // appending the literals
+  thisLits.reserve(thisLits.size() + otherLits.size());
   thisLits.insert(std::end(thisLits), std::begin(otherLits),
                   std::end(otherLits));
   std::sort(thisLits.begin(), thisLits.end());
@@ -288,7 +289,7 @@ void CClause::addLits(const std::vector<Lit> &otherLits) {
  *
  * @return     The literals in the clause
  */
-std::vector<Lit> CClause::getLits() const { return lits; }
+const std::vector<Lit> &CClause::getLits() const { return lits; }
 
 /**
  * @brief      Displays the clause.
@@ -0,0 +1,155 @@
+#include "classroom_matcher.h"
+
+#include <algorithm>
+#include <vector>
+#include "core/SolverTypes.h"
+#include "data.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the ClassroomMatcher object.
+ *
+ * @param      data        The data
+ * @param[in]  slots       The Slot of each Course, or -1 if it has none
+ * @param[in]  segments    The Segment of each Course, or -1 if it has none
+ * @param[in]  preferred   The preferred Classroom of each Course, or -1 if it
+ * has none
+ */
+ClassroomMatcher::ClassroomMatcher(Data *data, const std::vector<int> &slots,
+                                   const std::vector<int> &segments,
+                                   const std::vector<int> &preferred) {
+  this->data = data;
+  const FieldValueIndex &index = data->fieldValueIndex;
+  unsigned courseCount = index.getCourseCount();
+  unsigned classroomCount = index.getValueCount(FieldType::classroom);
+  courseAtoms.resize(courseCount);
+  candidates.resize(courseCount);
+  for (unsigned i = 0; i < courseCount; i++) {
+    if (slots[i] != -1 && segments[i] != -1) {
+      for (unsigned period : data->slotPeriods[slots[i]]) {
+        for (unsigned unit : data->segmentUnits[segments[i]]) {
+          courseAtoms[i].push_back(period * data->segmentUnitCount + unit);
+        }
+      }
+      std::sort(courseAtoms[i].begin(), courseAtoms[i].end());
+    }
+    for (unsigned j = 0; j < classroomCount; j++) {
+      if (index.getVar(i, FieldType::classroom, j) != var_Undef &&
+          static_cast<int>(j) != preferred[i]) {
+        candidates[i].push_back(j);
+      }
+    }
+    std::stable_sort(candidates[i].begin(), candidates[i].end(),
+                     [data](int first, int second) {
+                       return data->classrooms[first].getSize() <
+                              data->classrooms[second].getSize();
+                     });
+    if (preferred[i] != -1 &&
+        index.getVar(i, FieldType::classroom, preferred[i]) != var_Undef) {
+      candidates[i].insert(candidates[i].begin(), preferred[i]);
+    }
+  }
+  usedClassrooms.assign(data->periodCount * data->segmentUnitCount,
+                        std::vector<bool>(classroomCount, false));
+  assignment.assign(courseCount, -1);
+}
+
+/**
+ * @brief      Checks if a Classroom is not used by any matched Course at any
+ * time atom of a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  classroom  The classroom
+ *
+ * @return     True if the Classroom is free, False otherwise
+ */
+bool ClassroomMatcher::isFree(int course, int classroom) {
+  for (unsigned atom : courseAtoms[course]) {
+    if (usedClassrooms[atom][classroom]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief      Looks for an augmenting path from a Course, and matches the
+ * courses along it if one is found.
+ *
+ * @param[in]  course   The course
+ * @param      owners   The Course of the current time atom matched to each
+ * Classroom, or -1 if there is none
+ * @param      visited  Whether each Classroom has been visited
+ *
+ * @return     True if the Course was matched, False otherwise
+ */
+bool ClassroomMatcher::augment(int course, std::vector<int> &owners,
+                               std::vector<bool> &visited) {
+  for (int classroom : candidates[course]) {
+    if (visited[classroom] || !isFree(course, classroom)) {
+      continue;
+    }
+    visited[classroom] = true;
+    if (owners[classroom] == -1 ||
+        augment(owners[classroom], owners, visited)) {
+      owners[classroom] = course;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief      Assigns a Classroom to every Course.
+ *
+ * A Course without time atoms is given the first Classroom it tries.
+ *
+ * @return     True if every Course was assigned a Classroom, False otherwise
+ */
+bool ClassroomMatcher::match() {
+  unsigned classroomCount = data->classrooms.size();
+  std::vector<std::vector<int>> firstCourses(usedClassrooms.size());
+  for (unsigned i = 0; i < courseAtoms.size(); i++) {
+    if (courseAtoms[i].empty()) {
+      if (candidates[i].empty()) {
+        return false;
+      }
+      assignment[i] = candidates[i][0];
+      continue;
+    }
+    firstCourses[courseAtoms[i][0]].push_back(i);
+  }
+  for (unsigned atom = 0; atom < firstCourses.size(); atom++) {
+    if (firstCourses[atom].empty()) {
+      continue;
+    }
+    std::vector<int> owners(classroomCount, -1);
+    for (int course : firstCourses[atom]) {
+      std::vector<bool> visited(classroomCount, false);
+      if (!augment(course, owners, visited)) {
+        return false;
+      }
+    }
+    for (unsigned j = 0; j < classroomCount; j++) {
+      if (owners[j] == -1) {
+        continue;
+      }
+      assignment[owners[j]] = j;
+      for (unsigned courseAtom : courseAtoms[owners[j]]) {
+        usedClassrooms[courseAtom][j] = true;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief      Gets the Classroom assigned to a Course by match().
+ *
+ * @param[in]  course  The course
+ *
+ * @return     The index of the Classroom, or -1 if none is assigned
+ */
+int ClassroomMatcher::getClassroom(int course) { return assignment[course]; }
@@ -0,0 +1,145 @@
+#include "clause_sink.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MaxSATFormula.h"
+#include "core/SolverTypes.h"
+#include "mtl/Vec.h"
+#include "utils.h"
+
+using namespace NSPACE;
+using namespace openwbo;
+
+/**
+ * @brief      Constructs the FormulaClauseSink object.
+ *
+ * @param      formula  The formula to which clauses are added
+ */
+FormulaClauseSink::FormulaClauseSink(MaxSATFormula *formula) {
+  this->formula = formula;
+}
+
+/**
+ * @brief      Adds a clause to the formula as a hard or a soft clause,
+ * depending on its weight.
+ *
+ * @param[in]  lits    Pointer to the first literal of the clause
+ * @param[in]  size    The number of literals in the clause
+ * @param[in]  weight  The weight
+ */
+void FormulaClauseSink::addClause(const Lit *lits, unsigned size,
+                                  int64_t weight) {
+  if (weight == 0) {
+    return;
+  }
+  buffer.clear();
+  for (unsigned i = 0; i < size; i++) {
+    buffer.push(lits[i]);
+  }
+  if (weight < 0) {
+    formula->addHardClause(buffer);
+  } else {
+    formula->addSoftClause(weight, buffer);
+  }
+}
+
+/**
+ * @brief      Constructs the WCNFClauseSink object, and opens the file.
+ *
+ * @param[in]  fileName  The name of the file to write to
+ */
+WCNFClauseSink::WCNFClauseSink(std::string fileName) {
+  out.open(fileName);
+  if (!out.is_open()) {
+    LOG(ERROR) << "Could not open file " << fileName << " for writing";
+  }
+}
+
+/**
+ * @brief      Writes a clause to the file as a hard or a soft clause,
+ * depending on its weight.
+ *
+ * Variables are numbered from 1 in the file, so a Var v is written as v + 1.
+ *
+ * @param[in]  lits    Pointer to the first literal of the clause
+ * @param[in]  size    The number of literals in the clause
+ * @param[in]  weight  The weight
+ */
+void WCNFClauseSink::addClause(const Lit *lits, unsigned size, int64_t weight) {
+  if (weight == 0) {
+    return;
+  }
+  if (weight < 0) {
+    out << "h";
+  } else {
+    out << weight;
+  }
+  for (unsigned i = 0; i < size; i++) {
+    out << (sign(lits[i]) ? " -" : " ") << var(lits[i]) + 1;
+  }
+  out << " 0\n";
+}
+
+/**
+ * @brief      Constructs the BufferClauseSink object, with no clauses in it.
+ */
+BufferClauseSink::BufferClauseSink() : offsets(1, 0) {}
+
+/**
+ * @brief      Stores a clause along with its weight.
+ *
+ * @param[in]  lits    Pointer to the first literal of the clause
+ * @param[in]  size    The number of literals in the clause
+ * @param[in]  weight  The weight
+ */
+void BufferClauseSink::addClause(const Lit *lits, unsigned size,
+                                 int64_t weight) {
+  if (weight == 0) {
+    return;
+  }
+  this->lits.insert(std::end(this->lits), lits, lits + size);
+  offsets.push_back(this->lits.size());
+  weights.push_back(weight);
+}
+
+/**
+ * @brief      Gets the number of stored clauses.
+ *
+ * @return     The number of clauses
+ */
+unsigned BufferClauseSink::size() const { return weights.size(); }
+
+/**
+ * @brief      Gets the literals of a stored clause.
+ *
+ * @param[in]  index  The index of the clause
+ *
+ * @return     Pointer to the first literal of the clause
+ */
+const Lit *BufferClauseSink::getClause(unsigned index) const {
+  return lits.data() + offsets[index];
+}
+
+/**
+ * @brief      Gets the number of literals in a stored clause.
+ *
+ * @param[in]  index  The index of the clause
+ *
+ * @return     The number of literals in the clause
+ */
+unsigned BufferClauseSink::getClauseSize(unsigned index) const {
+  return offsets[index + 1] - offsets[index];
+}
+
+/**
+ * @brief      Gets the weight of a stored clause.
+ *
+ * @param[in]  index  The index of the clause
+ *
+ * @return     The weight of the clause
+ */
+int64_t BufferClauseSink::getWeight(unsigned index) const {
+  return weights[index];
+}
@@ -1,10 +1,11 @@
 #include "clauses.h"
 
+#include <cassert>
 #include <iostream>
 #include <vector>
 #include "cclause.h"
 #include "core/SolverTypes.h"
-#include "global_vars.h"
+#include "encoding_context.h"
 #include "utils.h"
 
 using namespace NSPACE;
@@ -13,73 +14,99 @@ using namespace NSPACE;
  * @brief      Constructs the Clauses object.
  *
  * @param[in]  clauses  The clauses in the set of clauses
+ * @param      context  The encoding context
  */
-Clauses::Clauses(const std::vector<CClause> &clauses) {
-  this->clauses = clauses;
+Clauses::Clauses(const std::vector<CClause> &clauses,
+                 EncodingContext *context) {
+  this->context = context;
+  addClauses(clauses);
 }
 
 /**
  * @brief      Constructs the Clauses object.
  *
- * @param[in]  clause  A single clause that forms the set of clauses
+ * @param[in]  clause   A single clause that forms the set of clauses
+ * @param      context  The encoding context
  */
-Clauses::Clauses(const CClause &clause) {
-  clauses.clear();
-  clauses.push_back(clause);
+Clauses::Clauses(const CClause &clause, EncodingContext *context) {
+  this->context = context;
+  addClauses(clause);
 }
 
 /**
  * @brief      Constructs the Clauses object.
  *
- * @param[in]  lit   A single literal, a Lit, that is converted
- *                   to a unit clause and forms the set of clauses
+ * @param[in]  lit      A single literal, a Lit, that is converted
+ *                      to a unit clause and forms the set of clauses
+ * @param      context  The encoding context
  */
-Clauses::Clauses(const Lit &lit) {
-  clauses.clear();
-  CClause clause(lit);
-  clauses.push_back(clause);
+Clauses::Clauses(const Lit &lit, EncodingContext *context) {
+  this->context = context;
+  addClause(&lit, 1);
 }
 
 /**
  * @brief      Constructs the Clauses object.
  *
- * @param[in]  var   A single variable, a Var, that is converted
- *                   to a literal with positive polarity, then
- *                   converted to a unit clause, which then forms
- *                   the set of clauses
+ * @param[in]  var      A single variable, a Var, that is converted
+ *                      to a literal with positive polarity, then
+ *                      converted to a unit clause, which then forms
+ *                      the set of clauses
+ * @param      context  The encoding context
  */
-Clauses::Clauses(const Var &var) {
-  clauses.clear();
-  CClause clause(var);
-  clauses.push_back(clause);
+Clauses::Clauses(const Var &var, EncodingContext *context) {
+  this->context = context;
+  Lit lit = mkLit(var, false);
+  addClause(&lit, 1);
 }
 
+/**
+ * @brief      Constructs the Clauses object, with no clauses in it, in a
+ * given encoding context.
+ *
+ * @param      context  The encoding context
+ */
+Clauses::Clauses(EncodingContext *context) { this->context = context; }
+
 /**
  * @brief      Constructs the Clauses object, with no clauses in it
  */
-Clauses::Clauses() { clauses.clear(); }
+Clauses::Clauses() {}
 
 /**
  * @brief      Defines the negation operation on a set of clauses.
  *
  * The negation of a set of clauses ((a1 OR a2) AND (b1 OR b2)) is defined
- * as ((~a1 AND ~a2) OR (~b1 AND ~b2)). The OR operation defined in this
- * class is then used to convert the Clauses to CNF form.
+ * as ((~a1 AND ~a2) OR (~b1 AND ~b2)). The negation of a single clause is
+ * returned directly as unit clauses. Otherwise, each clause is given a
+ * definition literal c, for which ~c is equivalent to the conjunction of its
+ * negated literals, and the result is the single clause (~c1 OR ~c2 OR ...).
+ * This keeps the size of the negation linear in the size of the clauses.
  *
  * @return     The result of the negation operation on the set of clauses
  */
 Clauses Clauses::operator~() {
-  if (clauses.size() == 0) {
+  if (size() == 0) {
     CClause clause;
-    return Clauses(clause);
+    return Clauses(clause, context);
   }
-  Clauses negationClause(~(clauses[0]));
-  for (unsigned i = 1; i < clauses.size(); i++) {
-    std::vector<CClause> negationClauseVector = ~(clauses[i]);
-    Clauses negationThisClause(negationClauseVector);
-    negationClause = (negationClause | negationThisClause);
+  if (size() == 1) {
+    // the negation of a clause is the conjunction of its negated literals
+    Clauses negationClause(context);
+    for (const Lit &lit : getClause(0)) {
+      Lit negatedLit = ~lit;
+      negationClause.addClause(&negatedLit, 1);
+    }
+    return negationClause;
+  }
+  assert(context != nullptr);
+  CClause negationClause;
+  for (unsigned i = 0; i < size(); i++) {
+    ClauseView clause = getClause(i);
+    negationClause.addLits(
+        ~context->defineClause(clause.begin(), clause.size()));
   }
-  return negationClause;
+  return Clauses(negationClause, context);
 }
 
 /**
@@ -96,11 +123,8 @@ Clauses Clauses::operator~() {
  * @return     A Clauses object with the result of the AND operation
  */
 Clauses Clauses::operator&(const Clauses &other) {
-  std::vector<CClause> thisClauses = clauses;
-  std::vector<CClause> otherClauses = other.clauses;
-  thisClauses.insert(std::end(thisClauses), std::begin(otherClauses),
-                     std::end(otherClauses));
-  Clauses result(thisClauses);
+  Clauses result(*this);
+  result.addClauses(other);
   return result;
 }
 
@@ -134,7 +158,7 @@ Clauses Clauses::operator&(const CClause &other) {
  * ...) & ...) # Add the following as hard clauses ~x | c1 (c1 is auxiliary
  * variable for (a1 | a2 | a3 | a4))
  * ...
- * x | ~c1 | c2 | ...
+ * x | ~c1 | ~c2 | ...
  * ~c1 | a1 | a2 | a3 | a4
  * c1 | ~a1
  * c1 | ~a2
@@ -142,65 +166,53 @@ Clauses Clauses::operator&(const CClause &other) {
  * # Return the following as soft clause
  * x | y
  *
+ * The auxiliary variables are obtained through getDefinition, so a unit
+ * clause is represented by its own literal, and clauses and sets of clauses
+ * that have already been encoded reuse their auxiliary variables.
+ *
  * @param      other  The Clauses object to perform the OR operation with
  *
  * @return     A Clauses object with the result of the OR operation
  */
 Clauses Clauses::operator|(const Clauses &other) {
-  if (other.getClauses().size() == 0) {
-    Clauses result = other;
+  EncodingContext *resultContext = getContext(other);
+  if (other.size() == 0) {
+    Clauses result(resultContext);
     return result;
   }
   // x and y are auxiliary variables for the sets of the clauses that are being
   // disjunctioned
-  Lit x = timetabler->newLiteral();
-  Lit y = timetabler->newLiteral();
-  Clauses result(CClause(x) | CClause(y));
-  vec<Lit> xrep;
-  xrep.push(x);
-  vec<Lit> yrep;
-  yrep.push(y);
-  for (unsigned i = 0; i < clauses.size(); i++) {
-    // c1 is the auxiliary variable for a ith clause
-    Lit c1 = timetabler->newLiteral();
-    xrep.push(~c1);
-    vec<Lit> clause;
-    clause.push(c1);
-    clause.push(~x);
-    timetabler->addToFormula(clause, -1);
-    CClause c1rep(~c1);
-    for (unsigned j = 0; j < clauses[i].getLits().size(); j++) {
-      c1rep.addLits(clauses[i].getLits()[j]);
-      vec<Lit> clause;
-      clause.push(c1);
-      clause.push(~clauses[i].getLits()[j]);
-      timetabler->addToFormula(clause, -1);
-    }
-    timetabler->addClauses(c1rep, -1);
-  }
-  for (unsigned i = 0; i < other.clauses.size(); i++) {
-    // c1 is the auxiliary variable for a ith clause
-    Lit c1 = timetabler->newLiteral();
-    yrep.push(~c1);
-    vec<Lit> clause;
-    clause.push(c1);
-    clause.push(~y);
-    timetabler->addToFormula(clause, -1);
-    CClause c1rep(~c1);
-    for (unsigned j = 0; j < other.clauses[i].getLits().size(); j++) {
-      c1rep.addLits(other.clauses[i].getLits()[j]);
-      vec<Lit> clause;
-      clause.push(c1);
-      clause.push(~other.clauses[i].getLits()[j]);
-      timetabler->addToFormula(clause, -1);
-    }
-    timetabler->addClauses(c1rep, -1);
-  }
-  timetabler->addToFormula(xrep, -1);
-  timetabler->addToFormula(yrep, -1);
+  Lit x = getDefinition(resultContext);
+  Lit y = other.getDefinition(resultContext);
+  Clauses result(CClause(x) | CClause(y), resultContext);
   return result;
 }
 
+/**
+ * @brief      Gives a literal that is equivalent to this set of clauses.
+ *
+ * Each clause is given a definition literal, and the set of clauses is defined
+ * as the conjunction of these literals, using the definitions cached by the
+ * given EncodingContext. Thus, a set of clauses that has already been defined,
+ * such as the same constraint between a pair of courses used in several
+ * constraints, reuses its literal instead of being encoded again.
+ *
+ * @param      context  The encoding context
+ *
+ * @return     The literal equivalent to this set of clauses
+ */
+Lit Clauses::getDefinition(EncodingContext *context) const {
+  assert(context != nullptr);
+  std::vector<Lit> clauseLits;
+  clauseLits.reserve(size());
+  for (unsigned i = 0; i < size(); i++) {
+    ClauseView clause = getClause(i);
+    clauseLits.push_back(
+        context->defineClause(clause.begin(), clause.size()));
+  }
+  return context->defineConjunction(clauseLits);
+}
+
 /**
  * @brief      Defines the disjunction operation between a Clauses and a
  * CClause.
@@ -235,7 +247,10 @@ Clauses Clauses::operator>>(const Clauses &other) {
  *
  * @param[in]  other  The CClause to add
  */
-void Clauses::addClauses(const CClause &other) { clauses.push_back(other); }
+void Clauses::addClauses(const CClause &other) {
+  const std::vector<Lit> &otherLits = other.getLits();
+  addClause(otherLits.data(), otherLits.size());
+}
 
 /**
  * @brief      Adds a vector of CClause to the set of clauses.
@@ -243,32 +258,114 @@ void Clauses::addClauses(const CClause &other) { clauses.push_back(other); }
  * @param[in]  other  The CClause vector to append
  */
 void Clauses::addClauses(const std::vector<CClause> &other) {
-  clauses.insert(std::end(clauses), std::begin(other), std::end(other));
+  for (const CClause &clause : other) {
+    addClauses(clause);
+  }
 }
 
 /**
  * @brief      Adds the clauses of a Clauses object to this object.
  *
+ * If this object does not have an EncodingContext, it takes the one of the
+ * other object.
+ *
  * @param[in]  other  The Clauses object whose clauses are to be added
  */
 void Clauses::addClauses(const Clauses &other) {
-  std::vector<CClause> otherClauses = other.getClauses();
-  addClauses(otherClauses);
+  if (context == nullptr) {
+    context = other.context;
+  }
+  if (&other == this) {
+    Clauses copy(other);
+    addClauses(copy);
+    return;
+  }
+  unsigned base = lits.size();
+  lits.insert(std::end(lits), std::begin(other.lits), std::end(other.lits));
+  offsets.reserve(offsets.size() + other.size());
+  for (unsigned i = 1; i < other.offsets.size(); i++) {
+    offsets.push_back(base + other.offsets[i]);
+  }
+}
+
+/**
+ * @brief      Appends a clause, given by its literals, to the literal pool.
+ *
+ * @param[in]  clauseLits  Pointer to the first literal of the clause
+ * @param[in]  length      The number of literals in the clause
+ */
+void Clauses::addClause(const Lit *clauseLits, unsigned length) {
+  lits.insert(std::end(lits), clauseLits, clauseLits + length);
+  offsets.push_back(lits.size());
+}
+
+/**
+ * @brief      Gets the number of clauses in this object.
+ *
+ * @return     The number of clauses
+ */
+unsigned Clauses::size() const { return offsets.size() - 1; }
+
+/**
+ * @brief      Gets a view of a clause in this object, without copying its
+ * literals.
+ *
+ * @param[in]  index  The index of the clause
+ *
+ * @return     A view of the clause
+ */
+ClauseView Clauses::getClause(unsigned index) const {
+  return ClauseView(lits.data() + offsets[index],
+                    offsets[index + 1] - offsets[index]);
 }
 
 /**
- * @brief      Gets the clauses in this object.
+ * @brief      Gets a copy of the clauses in this object.
+ *
+ * Prefer size and getClause to iterate over the clauses, which do not copy
+ * them.
  *
  * @return     The clauses
  */
-std::vector<CClause> Clauses::getClauses() const { return clauses; }
+std::vector<CClause> Clauses::getClauses() const {
+  std::vector<CClause> result;
+  result.reserve(size());
+  for (unsigned i = 0; i < size(); i++) {
+    ClauseView clause = getClause(i);
+    result.push_back(CClause(std::vector<Lit>(clause.begin(), clause.end())));
+  }
+  return result;
+}
+
+/**
+ * @brief      Gets the EncodingContext of this object.
+ *
+ * @return     The encoding context, or nullptr if there is none
+ */
+EncodingContext *Clauses::getContext() const { return context; }
+
+/**
+ * @brief      Gets the EncodingContext to be used for an operation between
+ * this object and another.
+ *
+ * @param[in]  other  The other Clauses object in the operation
+ *
+ * @return     The encoding context of this object if it has one, otherwise
+ * the one of the other object
+ */
+EncodingContext *Clauses::getContext(const Clauses &other) const {
+  return (context != nullptr) ? context : other.context;
+}
 
 /**
  * @brief      Displays the clauses in this object.
  */
 void Clauses::print() {
-  for (CClause c : clauses) {
-    c.printClause();
+  for (unsigned i = 0; i < size(); i++) {
+    for (const Lit &lit : getClause(i)) {
+      LOG_DEBUG(INFO) << (sign(lit) ? "-" : " ") << var(lit) << " ";
+    }
+    LOG_DEBUG(INFO) << "";
   }
   LOG_DEBUG(INFO) << "";
 }
@@ -276,4 +373,7 @@ void Clauses::print() {
 /**
  * @brief      Clears the Clauses object by removing all the clauses.
  */
-void Clauses::clear() { clauses.clear(); }
+void Clauses::clear() {
+  lits.clear();
+  offsets.assign(1, 0);
+}
@@ -0,0 +1,152 @@
+#include "conflict_graph.h"
+
+#include <utility>
+#include <vector>
+#include "core/SolverTypes.h"
+#include "data.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the ConflictGraph object, and builds its edges.
+ *
+ * The Data object must already contain the parsed fields, inputs, and
+ * intersection matrices.
+ *
+ * @param      data  The data
+ */
+ConflictGraph::ConflictGraph(Data *data) {
+  this->data = data;
+  build();
+}
+
+/**
+ * @brief      Gets the field values of a given FieldType that a Course could
+ * possibly be assigned.
+ *
+ * A field value is not possible if it is forbidden by the domain store, which
+ * also forbids the Classrooms that are smaller than the class size of the
+ * Course, unless the Course is fixed to them. For a Program, only core
+ * programs are considered.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ *
+ * @return     For every field value, whether it is possible for the Course
+ */
+std::vector<bool> ConflictGraph::getPossibleValues(int course,
+                                                   FieldType fieldType) {
+  unsigned valueCount = data->fieldValueIndex.getValueCount(fieldType);
+  std::vector<bool> result(valueCount, true);
+  for (unsigned i = 0; i < valueCount; i++) {
+    if (data->domains.isForbidden(course, fieldType, i)) {
+      result[i] = false;
+    }
+    if (fieldType == FieldType::program && !data->programs[i].isCoreProgram()) {
+      result[i] = false;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Gets the field values that intersect with at least one of the
+ * given field values.
+ *
+ * @param[in]  values         For every field value, whether it is included
+ * @param[in]  intersections  The intersection matrix of the field values
+ *
+ * @return     For every field value, whether it intersects an included value
+ */
+std::vector<bool> ConflictGraph::getReachableValues(
+    const std::vector<bool> &values,
+    const std::vector<std::vector<bool>> &intersections) {
+  std::vector<bool> result(values.size(), false);
+  for (unsigned i = 0; i < values.size(); i++) {
+    if (!values[i]) continue;
+    for (unsigned j = 0; j < values.size(); j++) {
+      if (intersections[i][j]) {
+        result[j] = true;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Checks if two sets of field values have a common field value.
+ *
+ * @param[in]  values1  For every field value, whether it is in the first set
+ * @param[in]  values2  For every field value, whether it is in the second set
+ *
+ * @return     True if there is a common field value, False otherwise
+ */
+bool ConflictGraph::haveCommonValue(const std::vector<bool> &values1,
+                                    const std::vector<bool> &values2) {
+  for (unsigned i = 0; i < values1.size(); i++) {
+    if (values1[i] && values2[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief      Builds the edges of the conflict graph.
+ *
+ * A pair of courses can be scheduled at intersecting times only if some
+ * possible Segment of one intersects some possible Segment of the other, and
+ * likewise for Slots. For such pairs, an edge is added for each of the
+ * Instructor, Classroom, and Program field types for which the courses have a
+ * common possible field value.
+ */
+void ConflictGraph::build() {
+  edges.clear();
+  edges.resize(Global::FIELD_COUNT);
+  const FieldType sharedFieldTypes[] = {
+      FieldType::instructor, FieldType::classroom, FieldType::program};
+  unsigned courseCount = data->courses.size();
+  std::vector<std::vector<std::vector<bool>>> possible(
+      courseCount, std::vector<std::vector<bool>>(Global::FIELD_COUNT));
+  std::vector<std::vector<bool>> reachableSegments(courseCount);
+  std::vector<std::vector<bool>> reachableSlots(courseCount);
+  for (unsigned i = 0; i < courseCount; i++) {
+    for (FieldType fieldType : sharedFieldTypes) {
+      possible[i][fieldType] = getPossibleValues(i, fieldType);
+    }
+    possible[i][FieldType::segment] =
+        getPossibleValues(i, FieldType::segment);
+    possible[i][FieldType::slot] = getPossibleValues(i, FieldType::slot);
+    reachableSegments[i] = getReachableValues(possible[i][FieldType::segment],
+                                              data->segmentIntersections);
+    reachableSlots[i] = getReachableValues(possible[i][FieldType::slot],
+                                           data->slotIntersections);
+  }
+  for (unsigned i = 0; i < courseCount; i++) {
+    for (unsigned j = i + 1; j < courseCount; j++) {
+      if (!haveCommonValue(reachableSegments[i],
+                           possible[j][FieldType::segment]) ||
+          !haveCommonValue(reachableSlots[i], possible[j][FieldType::slot])) {
+        continue;
+      }
+      for (FieldType fieldType : sharedFieldTypes) {
+        if (haveCommonValue(possible[i][fieldType], possible[j][fieldType])) {
+          edges[fieldType].push_back(std::make_pair(i, j));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief      Gets the edges of the conflict graph for a given FieldType.
+ *
+ * @param[in]  fieldType  The field type
+ *
+ * @return     The edges, as pairs of course indices
+ */
+const std::vector<std::pair<unsigned, unsigned>> &ConflictGraph::getEdges(
+    FieldType fieldType) {
+  return edges[fieldType];
+}
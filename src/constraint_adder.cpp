@@ -1,11 +1,22 @@
 #include "constraint_adder.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
+#include "clause_sink.h"
 #include "clauses.h"
+#include "conflict_graph.h"
 #include "constraint_encoder.h"
 #include "core/SolverTypes.h"
+#include "encoding_context.h"
 #include "global.h"
+#include "symmetry_detector.h"
 #include "timetabler.h"
 #include "utils.h"
 
@@ -18,94 +29,227 @@ using namespace NSPACE;
  * @param      timetabler  The time tabler
  */
 ConstraintAdder::ConstraintAdder(ConstraintEncoder *encoder,
-                                 Timetabler *timetabler) {
+                                 Timetabler *timetabler)
+    : conflictGraph(&timetabler->data) {
   this->encoder = encoder;
   this->timetabler = timetabler;
 }
 
 /**
- * @brief      Imposes the constraint that a given FieldType value should be
+ * @brief      Adds the constraint that a given FieldType value should be
  * true for at most one Course at a time.
  *
  * For example, this includes constraints such as enforcing that a given
  * Instructor cannot have two courses at the same time. Here, a time refers to a
  * combination of segment and slot. This is not added directly, but called by
- * other functions.
+ * other functions. The clauses for each pair of courses are added as soon as
+ * they are encoded.
  *
- * @param[in]  fieldType  The field type on which this constraint is imposed
- *
- * @return     A Clauses object describing this constraint
+ * @param[in]  fieldType   The field type on which this constraint is imposed
+ * @param[in]  clauseType  The PredefinedClauses member denoting the constraint
+ * type
  */
-Clauses ConstraintAdder::fieldSingleValueAtATime(FieldType fieldType) {
-  Clauses result;
-  result.clear();
-  std::vector<Course> courses = timetabler->data.courses;
-  for (unsigned i = 0; i < courses.size(); i++) {
-    for (unsigned j = i + 1; j < courses.size(); j++) {
+void ConstraintAdder::fieldSingleValueAtATime(FieldType fieldType,
+                                              PredefinedClauses clauseType) {
+  if (timetabler->data.predefinedClausesWeights[clauseType] != 0) {
+    if (timetabler->data.timeEncoding == TimeEncoding::occupancy) {
+      fieldSingleValuePerTimeAtom(fieldType, clauseType);
+    } else {
       /*
-       * For every pair of courses, either the field value of the
-       * FieldType is different or their times do not intersect
+       * For every pair of courses that could conflict, either the field
+       * value of the FieldType is different or their times do not intersect
        */
-      Clauses antecedent =
-          encoder->hasSameFieldTypeNotSameValue(i, j, fieldType);
-      Clauses consequent = encoder->notIntersectingTime(i, j);
-      result.addClauses(antecedent | consequent);
+      addPairConstraints(
+          fieldType, clauseType,
+          [fieldType](ConstraintEncoder *encoder, unsigned i, unsigned j) {
+            Clauses antecedent =
+                encoder->hasSameFieldTypeNotSameValue(i, j, fieldType);
+            Clauses consequent = encoder->notIntersectingTime(i, j);
+            return antecedent | consequent;
+          });
     }
   }
-  return result;
+  timetabler->addHighLevelConstraintClauses(clauseType, -1);
+}
+
+/**
+ * @brief      Adds the clauses of a predefined constraint on every pair of
+ * courses joined by an edge of the conflict graph for a given FieldType.
+ *
+ * If more than one thread is to be used, the edges are split into contiguous
+ * ranges, one per thread. Each thread encodes its range with its own
+ * ConstraintEncoder and EncodingContext, which stores the clauses in a buffer
+ * and issues variables from the same first variable. The buffers are then
+ * added to the EncodingContext of the Timetabler in the order of the ranges,
+ * with the variables of each thread renumbered, so the formula only depends
+ * on the number of threads.
+ *
+ * @param[in]  fieldType   The field type of the conflict graph edges
+ * @param[in]  clauseType  The PredefinedClauses member denoting the constraint
+ * type
+ * @param[in]  encode      Gives the clauses of the constraint for a pair of
+ * courses, using the given ConstraintEncoder
+ */
+void ConstraintAdder::addPairConstraints(
+    FieldType fieldType, PredefinedClauses clauseType,
+    const std::function<Clauses(ConstraintEncoder *, unsigned, unsigned)>
+        &encode) {
+  const std::vector<std::pair<unsigned, unsigned>> &edges =
+      conflictGraph.getEdges(fieldType);
+  unsigned threadCount = std::min<std::size_t>(
+      std::max(timetabler->data.threadCount, 1u), edges.size());
+  if (threadCount <= 1) {
+    for (const std::pair<unsigned, unsigned> &edge : edges) {
+      addGuardedConstraintClauses(
+          clauseType, encode(encoder, edge.first, edge.second), -1);
+    }
+    return;
+  }
+  Var guard = timetabler->getGuard(
+      timetabler->data.predefinedConstraintVars[clauseType][0],
+      timetabler->data.predefinedClausesWeights[clauseType]);
+  EncodingContext *context = timetabler->getEncodingContext();
+  Var firstVar = context->nVars();
+  std::vector<BufferClauseSink *> buffers(threadCount);
+  std::vector<EncodingContext *> contexts(threadCount);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; t++) {
+    buffers[t] = new BufferClauseSink();
+    contexts[t] = new EncodingContext(buffers[t], firstVar);
+    unsigned begin = edges.size() * t / threadCount;
+    unsigned end = edges.size() * (t + 1) / threadCount;
+    threads.push_back(std::thread([this, &edges, &encode, &contexts, guard, t,
+                                   begin, end]() {
+      ConstraintEncoder threadEncoder(timetabler, contexts[t]);
+      for (unsigned k = begin; k < end; k++) {
+        contexts[t]->addGuardedClauses(
+            guard, encode(&threadEncoder, edges[k].first, edges[k].second),
+            -1);
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threadCount; t++) {
+    threads[t].join();
+    context->addBufferedClauses(*buffers[t], firstVar, contexts[t]->nVars());
+    // the EncodingContext owns the buffer
+    delete contexts[t];
+  }
 }
 
 /**
- * @brief      Imposes the constraint that an Instructor can have only a single
+ * @brief      Adds the constraint that a given FieldType value should be
+ * true for at most one Course occupying each time atom.
+ *
+ * This is the occupancy time encoding of fieldSingleValueAtATime. Instead of
+ * constraining every pair of courses, an at most one constraint is imposed for
+ * every field value and time atom, so the size of the constraint grows
+ * linearly with the number of courses. For a Program, only core programs are
+ * constrained.
+ *
+ * @param[in]  fieldType   The field type on which this constraint is imposed
+ * @param[in]  clauseType  The PredefinedClauses member denoting the constraint
+ * type
+ */
+void ConstraintAdder::fieldSingleValuePerTimeAtom(
+    FieldType fieldType, PredefinedClauses clauseType) {
+  if (timetabler->data.courses.size() == 0) {
+    return;
+  }
+  unsigned valueCount =
+      timetabler->data.fieldValueIndex.getValueCount(fieldType);
+  unsigned atomCount =
+      timetabler->data.periodCount * timetabler->data.segmentUnitCount;
+  for (unsigned i = 0; i < valueCount; i++) {
+    if (fieldType == FieldType::program &&
+        !timetabler->data.programs[i].isCoreProgram()) {
+      continue;
+    }
+    for (unsigned j = 0; j < atomCount; j++) {
+      addGuardedConstraintClauses(
+          clauseType,
+          encoder->fieldValueAtMostOneCourseInTimeAtom(fieldType, i, j), -1);
+    }
+  }
+}
+
+/**
+ * @brief      Adds the hard clauses that define the occupancy variables of
+ * every Course, which are needed by the occupancy time encoding.
+ */
+void ConstraintAdder::addOccupancyDefinitions() {
+  for (unsigned i = 0; i < timetabler->data.courses.size(); i++) {
+    timetabler->addClauses(encoder->occupiesTimeAtoms(i), -1);
+  }
+}
+
+/**
+ * @brief      Adds the hard clauses that define the segment order variables
+ * of every Course, which are needed by the order segment encoding.
+ */
+void ConstraintAdder::addSegmentOrderDefinitions() {
+  for (unsigned i = 0; i < timetabler->data.segmentStartVars.size(); i++) {
+    timetabler->addClauses(encoder->segmentOrderDefinitions(i), -1);
+  }
+}
+
+/**
+ * @brief      Adds the constraint that an Instructor can have only a single
  *             course at a given time.
  *
  * This simply calls fieldSingleValueAtATime with the FieldType as
  * FieldType::instructor. By default, this constraint is hard.
- *
- * @return     A Clauses object describing this constraint
  */
-Clauses ConstraintAdder::instructorSingleCourseAtATime() {
-  return fieldSingleValueAtATime(FieldType::instructor);
+void ConstraintAdder::instructorSingleCourseAtATime() {
+  fieldSingleValueAtATime(FieldType::instructor,
+                          PredefinedClauses::instructorSingleCourseAtATime);
 }
 
 /**
- * @brief      Imposes the constraint that a Classroom can have only a single
+ * @brief      Adds the constraint that a Classroom can have only a single
  *             course at a given time.
  *
  * This simply calls fieldSingleValueAtATime with the FieldType as
  * FieldType::classroom. By default, this constraint is hard.
- *
- * @return     A Clauses object describing this constraint
  */
-Clauses ConstraintAdder::classroomSingleCourseAtATime() {
-  return fieldSingleValueAtATime(FieldType::classroom);
+void ConstraintAdder::classroomSingleCourseAtATime() {
+  if (timetabler->matchesClassrooms()) {
+    // the Classrooms are assigned after solving, see assignClassrooms
+    timetabler->addHighLevelConstraintClauses(
+        PredefinedClauses::classroomSingleCourseAtATime, -1);
+    return;
+  }
+  fieldSingleValueAtATime(FieldType::classroom,
+                          PredefinedClauses::classroomSingleCourseAtATime);
 }
 
 /**
- * @brief      Imposes the constraint that if two courses are core for
+ * @brief      Adds the constraint that if two courses are core for
  *             a Program, then they are not scheduled at an intersecting
  *             time.
  *
  * By default, this constraint is hard.
- *
- * @return     A Clauses object describing the constraint
  */
-Clauses ConstraintAdder::programSingleCoreCourseAtATime() {
-  Clauses result;
-  result.clear();
-  std::vector<Course> courses = timetabler->data.courses;
-  for (unsigned i = 0; i < courses.size(); i++) {
-    for (unsigned j = i + 1; j < courses.size(); j++) {
-      /*
-       * For every pair of courses, either there is no Program for which
-       * they are both core or their times do not intersect
-       */
-      Clauses antecedent = encoder->hasNoCommonCoreProgram(i, j);
-      Clauses consequent = encoder->notIntersectingTime(i, j);
-      result.addClauses(antecedent | consequent);
-    }
+void ConstraintAdder::programSingleCoreCourseAtATime() {
+  PredefinedClauses clauseType =
+      PredefinedClauses::programSingleCoreCourseAtATime;
+  if (timetabler->data.timeEncoding == TimeEncoding::occupancy) {
+    fieldSingleValueAtATime(FieldType::program, clauseType);
+    return;
   }
-  return result;
+  if (timetabler->data.predefinedClausesWeights[clauseType] != 0) {
+    /*
+     * For every pair of courses that could conflict, either there is no
+     * Program for which they are both core or their times do not intersect
+     */
+    addPairConstraints(
+        FieldType::program, clauseType,
+        [](ConstraintEncoder *encoder, unsigned i, unsigned j) {
+          Clauses antecedent = encoder->hasNoCommonCoreProgram(i, j);
+          Clauses consequent = encoder->notIntersectingTime(i, j);
+          return antecedent | consequent;
+        });
+  }
+  timetabler->addHighLevelConstraintClauses(clauseType, -1);
 }
 
 /**
@@ -143,24 +287,45 @@ std::vector<Clauses> ConstraintAdder::minorInMinorTime() {
  * category could not be satisfied, in order to help in making the necessary
  * modifications.
  *
- * @param[in]  fieldType  The field type on which this constraint is imposed
+ * The half that at most one value is True is added here as a cardinality
+ * constraint with the weight of the constraint, see
+ * Timetabler::addCardinality. The high level variables only guard the half
+ * that at least one value is True, as a Course that cannot have any value is
+ * what they report.
  *
- * @return     A Clauses object describing the constraint
+ * @param[in]  fieldType   The field type on which this constraint is imposed
+ * @param[in]  clauseType  The PredefinedClauses member denoting the
+ * constraint
+ *
+ * @return     For every Course, a Clauses object describing that at least one
+ * value is True
  */
 std::vector<Clauses> ConstraintAdder::exactlyOneFieldValuePerCourse(
-    FieldType fieldType) {
+    FieldType fieldType, PredefinedClauses clauseType) {
   std::vector<Course> courses = timetabler->data.courses;
   std::vector<Clauses> result(courses.size());
   for (unsigned i = 0; i < courses.size(); i++) {
     result[i].clear();
-    // exactly one field value must be true
-    Clauses exactlyOneFieldValue =
-        encoder->hasExactlyOneFieldValueTrue(i, fieldType);
-    Clauses cclause(timetabler->data.highLevelVars[i][fieldType]);
+    // at most one field value can be true
+    timetabler->addCardinality(
+        encoder->getFieldValueLits(i, fieldType), 1,
+        timetabler->data.predefinedConstraintVars[clauseType][i],
+        timetabler->data.predefinedClausesWeights[clauseType]);
+    // at least one field value must be true
+    Clauses atLeastOneFieldValue =
+        encoder->hasAtLeastOneFieldValueTrue(i, fieldType);
+    Var selector = timetabler->getGuard(
+        timetabler->data.highLevelVars[i][fieldType],
+        timetabler->data.highLevelVarWeights[fieldType]);
+    if (selector == var_Undef) {
+      result[i].addClauses(atLeastOneFieldValue);
+      continue;
+    }
+    Clauses cclause(selector);
     // high level variable implies the clause, and by default is hard
     // if high level variable is false, this clause could not be satisfied
     // this provides a reason to the user
-    result[i].addClauses(cclause >> exactlyOneFieldValue);
+    result[i].addClauses(cclause >> atLeastOneFieldValue);
   }
   return result;
 }
@@ -177,23 +342,32 @@ std::vector<Clauses> ConstraintAdder::exactlyOneFieldValuePerCourse(
 void ConstraintAdder::addSingleConstraint(PredefinedClauses clauseType,
                                           const Clauses &clauses,
                                           const int course) {
-  if (course == -1) {
-    if (timetabler->data.predefinedClausesWeights[clauseType] != 0) {
-      Clauses hardConsequent =
-          CClause(timetabler->data.predefinedConstraintVars[clauseType][0]) >>
-          clauses;
-      timetabler->addClauses(hardConsequent, -1);
-    }
-    timetabler->addHighLevelConstraintClauses(clauseType, -1);
-  } else {
-    if (timetabler->data.predefinedClausesWeights[clauseType] != 0) {
-      Clauses hardConsequent =
-          CClause(
-              timetabler->data.predefinedConstraintVars[clauseType][course]) >>
-          clauses;
-      timetabler->addClauses(hardConsequent, -1);
-    }
-    timetabler->addHighLevelConstraintClauses(clauseType, course);
+  addGuardedConstraintClauses(clauseType, clauses, course);
+  timetabler->addHighLevelConstraintClauses(clauseType, course);
+}
+
+/**
+ * @brief      Adds the clauses of a predefined constraint to the solver as hard
+ * clauses that must hold only if its high level variable is True.
+ *
+ * The clauses are not added if the constraint is disabled.
+ *
+ * @param[in]  clauseType  The PredefinedClauses member denoting the constraint
+ * type
+ * @param[in]  clauses     The clauses to be added
+ * @param[in]  course      The corresponding course index (-1 for if there is no
+ * corresponding course)
+ */
+void ConstraintAdder::addGuardedConstraintClauses(PredefinedClauses clauseType,
+                                                  const Clauses &clauses,
+                                                  const int course) {
+  int weight = timetabler->data.predefinedClausesWeights[clauseType];
+  if (weight != 0) {
+    Var selector =
+        timetabler->data
+            .predefinedConstraintVars[clauseType][course == -1 ? 0 : course];
+    timetabler->addGuardedClauses(timetabler->getGuard(selector, weight),
+                                  clauses, -1);
   }
 }
 
@@ -203,13 +377,14 @@ void ConstraintAdder::addSingleConstraint(PredefinedClauses clauseType,
  */
 void ConstraintAdder::addConstraints() {
   std::vector<int> weights = timetabler->data.predefinedClausesWeights;
+  if (timetabler->data.timeEncoding == TimeEncoding::occupancy) {
+    addOccupancyDefinitions();
+  }
+  addSegmentOrderDefinitions();
   // add the constraints to the formula
-  addSingleConstraint(PredefinedClauses::instructorSingleCourseAtATime,
-                      instructorSingleCourseAtATime(), -1);
-  addSingleConstraint(PredefinedClauses::classroomSingleCourseAtATime,
-                      classroomSingleCourseAtATime(), -1);
-  addSingleConstraint(PredefinedClauses::programSingleCoreCourseAtATime,
-                      programSingleCoreCourseAtATime(), -1);
+  instructorSingleCourseAtATime();
+  classroomSingleCourseAtATime();
+  programSingleCoreCourseAtATime();
 
   auto clauses = minorInMinorTime();
   for (unsigned i = 0; i < clauses.size(); i++) {
@@ -222,34 +397,34 @@ void ConstraintAdder::addConstraints() {
                         clauses[i], i);
   }
 
-  clauses = exactlyOneFieldValuePerCourse(FieldType::slot);
+  PredefinedClauses clauseType = PredefinedClauses::exactlyOneSlotPerCourse;
+  clauses = exactlyOneFieldValuePerCourse(FieldType::slot, clauseType);
   for (unsigned i = 0; i < clauses.size(); i++) {
-    addSingleConstraint(PredefinedClauses::exactlyOneSlotPerCourse, clauses[i],
-                        i);
+    addSingleConstraint(clauseType, clauses[i], i);
   }
 
-  clauses = exactlyOneFieldValuePerCourse(FieldType::classroom);
+  clauseType = PredefinedClauses::exactlyOneClassroomPerCourse;
+  clauses = exactlyOneFieldValuePerCourse(FieldType::classroom, clauseType);
   for (unsigned i = 0; i < clauses.size(); i++) {
-    addSingleConstraint(PredefinedClauses::exactlyOneClassroomPerCourse,
-                        clauses[i], i);
+    addSingleConstraint(clauseType, clauses[i], i);
   }
 
-  clauses = exactlyOneFieldValuePerCourse(FieldType::instructor);
+  clauseType = PredefinedClauses::exactlyOneInstructorPerCourse;
+  clauses = exactlyOneFieldValuePerCourse(FieldType::instructor, clauseType);
   for (unsigned i = 0; i < clauses.size(); i++) {
-    addSingleConstraint(PredefinedClauses::exactlyOneInstructorPerCourse,
-                        clauses[i], i);
+    addSingleConstraint(clauseType, clauses[i], i);
   }
 
-  clauses = exactlyOneFieldValuePerCourse(FieldType::isMinor);
+  clauseType = PredefinedClauses::exactlyOneIsMinorPerCourse;
+  clauses = exactlyOneFieldValuePerCourse(FieldType::isMinor, clauseType);
   for (unsigned i = 0; i < clauses.size(); i++) {
-    addSingleConstraint(PredefinedClauses::exactlyOneIsMinorPerCourse,
-                        clauses[i], i);
+    addSingleConstraint(clauseType, clauses[i], i);
   }
 
-  clauses = exactlyOneFieldValuePerCourse(FieldType::segment);
+  clauseType = PredefinedClauses::exactlyOneSegmentPerCourse;
+  clauses = exactlyOneFieldValuePerCourse(FieldType::segment, clauseType);
   for (unsigned i = 0; i < clauses.size(); i++) {
-    addSingleConstraint(PredefinedClauses::exactlyOneSegmentPerCourse,
-                        clauses[i], i);
+    addSingleConstraint(clauseType, clauses[i], i);
   }
 
   clauses = coreInMorningTime();
@@ -324,3 +499,90 @@ std::vector<Clauses> ConstraintAdder::programAtMostOneOfCoreOrElective() {
   }
   return result;
 }
+
+/**
+ * @brief      Adds the hard clauses that break the symmetries between
+ * interchangeable Classrooms and between interchangeable Slots, if enabled.
+ *
+ * This must be called after all other constraints, including custom
+ * constraints, have been added, as these decide which field values are
+ * interchangeable. In a session, the clauses are only enforced while nothing
+ * is assumed, see Timetabler::newSymmetrySelector. The phase hints are mapped
+ * to a timetable that satisfies the clauses, see orderPhaseHints().
+ */
+void ConstraintAdder::addSymmetryBreaking() {
+  if (!timetabler->data.symmetryBreaking) {
+    return;
+  }
+  SymmetryDetector detector(&timetabler->data);
+  const FieldType fieldTypes[] = {FieldType::classroom, FieldType::slot};
+  for (FieldType fieldType : fieldTypes) {
+    for (const std::vector<int> &values : detector.getClasses(fieldType)) {
+      LOG(INFO) << "Breaking the symmetry between " << values.size() << " "
+                << Utils::getFieldTypeName(fieldType) << " values";
+      orderPhaseHints(fieldType, values);
+      timetabler->addGuardedClauses(timetabler->newSymmetrySelector(),
+                                    encoder->valuePrecedence(fieldType, values),
+                                    -1);
+    }
+  }
+}
+
+/**
+ * @brief      Renames the field values of a class of interchangeable field
+ * values in the phase hints, so that they are first used in their order.
+ *
+ * The hints of a previous timetable may use the values in any order, which
+ * the clauses that break the symmetry forbid. Renaming the values in the
+ * order in which the courses first use them maps the hinted timetable to an
+ * equivalent one that the clauses allow.
+ *
+ * @param[in]  fieldType  The field type
+ * @param[in]  values     The indices of the interchangeable field values, in
+ * the order in which they are to be first used
+ */
+void ConstraintAdder::orderPhaseHints(FieldType fieldType,
+                                      const std::vector<int> &values) {
+  Data &data = timetabler->data;
+  if (data.phaseHints.empty()) {
+    return;
+  }
+  std::unordered_set<Var> hinted;
+  for (Lit hint : data.phaseHints) {
+    if (!sign(hint)) {
+      hinted.insert(var(hint));
+    }
+  }
+  // the positions of the values in the order of their first use
+  std::vector<unsigned> order;
+  std::vector<bool> used(values.size(), false);
+  for (unsigned i = 0; i < data.courses.size(); i++) {
+    for (unsigned t = 0; t < values.size(); t++) {
+      Var v = data.fieldValueIndex.getVar(i, fieldType, values[t]);
+      if (!used[t] && v != var_Undef && hinted.count(v) != 0) {
+        order.push_back(t);
+        used[t] = true;
+      }
+    }
+  }
+  for (unsigned t = 0; t < values.size(); t++) {
+    if (!used[t]) {
+      order.push_back(t);
+    }
+  }
+  std::unordered_map<Var, Var> renamed;
+  for (unsigned i = 0; i < data.courses.size(); i++) {
+    for (unsigned r = 0; r < values.size(); r++) {
+      Var v = data.fieldValueIndex.getVar(i, fieldType, values[order[r]]);
+      if (v != var_Undef) {
+        renamed[v] = data.fieldValueIndex.getVar(i, fieldType, values[r]);
+      }
+    }
+  }
+  for (Lit &hint : data.phaseHints) {
+    auto it = renamed.find(var(hint));
+    if (it != renamed.end()) {
+      hint = mkLit(it->second, sign(hint));
+    }
+  }
+}
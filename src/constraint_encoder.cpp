@@ -1,11 +1,13 @@
 #include "constraint_encoder.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
 #include "cclause.h"
 #include "clauses.h"
 #include "core/SolverTypes.h"
+#include "encoding_context.h"
 #include "global.h"
 #include "timetabler.h"
 
@@ -16,9 +18,26 @@ using namespace NSPACE;
  *
  * @param      timetabler  The time tabler
  */
-ConstraintEncoder::ConstraintEncoder(Timetabler *timetabler) {
+ConstraintEncoder::ConstraintEncoder(Timetabler *timetabler)
+    : index(timetabler->data.fieldValueIndex) {
   this->timetabler = timetabler;
-  this->vars = timetabler->data.fieldValueVars;
+  this->context = timetabler->getEncodingContext();
+}
+
+/**
+ * @brief      Constructs the ConstraintEncoder object, which creates its
+ * Clauses in a given EncodingContext instead of the one of the Timetabler.
+ *
+ * This is used by workers that encode constraints in parallel.
+ *
+ * @param      timetabler  The time tabler
+ * @param      context     The encoding context
+ */
+ConstraintEncoder::ConstraintEncoder(Timetabler *timetabler,
+                                     EncodingContext *context)
+    : index(timetabler->data.fieldValueIndex) {
+  this->timetabler = timetabler;
+  this->context = context;
 }
 
 /**
@@ -37,16 +56,22 @@ ConstraintEncoder::ConstraintEncoder(Timetabler *timetabler) {
  */
 Clauses ConstraintEncoder::hasSameFieldTypeAndValue(int course1, int course2,
                                                     FieldType fieldType) {
-  Clauses result;
-  for (unsigned i = 0; i < vars[course1][fieldType].size(); i++) {
+  Clauses result(CClause(), context);
+  bool first = true;
+  for (unsigned i = 0; i < index.getValueCount(fieldType); i++) {
+    if (!canHaveFieldValue(course1, fieldType, i) ||
+        !canHaveFieldValue(course2, fieldType, i)) {
+      continue;
+    }
     CClause field1, field2;
-    field1.createLitAndAdd(vars[course1][fieldType][i]);
-    field2.createLitAndAdd(vars[course2][fieldType][i]);
-    Clauses conjunction(field1 & field2);
-    if (i == 0)
+    field1.createLitAndAdd(index.getVar(course1, fieldType, i));
+    field2.createLitAndAdd(index.getVar(course2, fieldType, i));
+    Clauses conjunction(field1 & field2, context);
+    if (first)
       result = conjunction;
     else
       result = result | conjunction;
+    first = false;
   }
   return result;
 }
@@ -68,11 +93,15 @@ Clauses ConstraintEncoder::hasSameFieldTypeAndValue(int course1, int course2,
 Clauses ConstraintEncoder::hasSameFieldTypeNotSameValue(int course1,
                                                         int course2,
                                                         FieldType fieldType) {
-  Clauses result;
-  for (unsigned i = 0; i < vars[course1][fieldType].size(); i++) {
+  Clauses result(context);
+  for (unsigned i = 0; i < index.getValueCount(fieldType); i++) {
+    if (!canHaveFieldValue(course1, fieldType, i) ||
+        !canHaveFieldValue(course2, fieldType, i)) {
+      continue;
+    }
     CClause resultClause;
-    resultClause.addLits(~mkLit(vars[course1][fieldType][i], false));
-    resultClause.addLits(~mkLit(vars[course2][fieldType][i], false));
+    resultClause.addLits(~mkLit(index.getVar(course1, fieldType, i), false));
+    resultClause.addLits(~mkLit(index.getVar(course2, fieldType, i), false));
     result.addClauses(resultClause);
   }
   return result;
@@ -88,17 +117,21 @@ Clauses ConstraintEncoder::hasSameFieldTypeNotSameValue(int course1,
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::hasCommonProgram(int course1, int course2) {
-  Clauses result;
-  for (unsigned i = 0; i < vars[course1][FieldType::program].size(); i++) {
-    if (timetabler->data.programs[i].isCoreProgram()) {
+  Clauses result(CClause(), context);
+  bool first = true;
+  for (unsigned i = 0; i < index.getValueCount(FieldType::program); i++) {
+    if (timetabler->data.programs[i].isCoreProgram() &&
+        canHaveFieldValue(course1, FieldType::program, i) &&
+        canHaveFieldValue(course2, FieldType::program, i)) {
       CClause field1, field2;
-      field1.createLitAndAdd(vars[course1][FieldType::program][i]);
-      field2.createLitAndAdd(vars[course2][FieldType::program][i]);
-      Clauses conjunction(field1 & field2);
-      if (i == 0)
+      field1.createLitAndAdd(index.getVar(course1, FieldType::program, i));
+      field2.createLitAndAdd(index.getVar(course2, FieldType::program, i));
+      Clauses conjunction(field1 & field2, context);
+      if (first)
         result = conjunction;
       else
         result = result | conjunction;
+      first = false;
     }
   }
   return result;
@@ -117,12 +150,16 @@ Clauses ConstraintEncoder::hasCommonProgram(int course1, int course2) {
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::hasNoCommonCoreProgram(int course1, int course2) {
-  Clauses result;
-  for (unsigned i = 0; i < vars[course1][FieldType::program].size(); i++) {
-    if (timetabler->data.programs[i].isCoreProgram()) {
+  Clauses result(context);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::program); i++) {
+    if (timetabler->data.programs[i].isCoreProgram() &&
+        canHaveFieldValue(course1, FieldType::program, i) &&
+        canHaveFieldValue(course2, FieldType::program, i)) {
       CClause resultClause;
-      resultClause.addLits(~mkLit(vars[course1][FieldType::program][i], false));
-      resultClause.addLits(~mkLit(vars[course2][FieldType::program][i], false));
+      resultClause.addLits(
+          ~mkLit(index.getVar(course1, FieldType::program, i), false));
+      resultClause.addLits(
+          ~mkLit(index.getVar(course2, FieldType::program, i), false));
       result.addClauses(resultClause);
     }
   }
@@ -154,6 +191,9 @@ Clauses ConstraintEncoder::notIntersectingTime(int course1, int course2) {
  *             an intersecting value for a given FieldType, where the FieldType
  * is of a time field, which is either a Segment or a Slot.
  *
+ * If the order segment encoding is used, Segments are compared through their
+ * order variables, see notIntersectingSegmentOrder.
+ *
  * @param[in]  course1    The course 1
  * @param[in]  course2    The course 2
  * @param[in]  fieldType  The field type
@@ -163,20 +203,25 @@ Clauses ConstraintEncoder::notIntersectingTime(int course1, int course2) {
 Clauses ConstraintEncoder::notIntersectingTimeField(int course1, int course2,
                                                     FieldType fieldType) {
   assert(fieldType == FieldType::segment || fieldType == FieldType::slot);
-  assert(vars[course1][fieldType].size() == vars[course2][fieldType].size());
   assert(course1 != course2);
-  Clauses result;
-  for (unsigned i = 0; i < vars[course1][fieldType].size(); i++) {
-    Clauses hasFieldValue1(vars[course1][fieldType][i]);
-    Clauses notIntersecting1;
-    for (unsigned j = 0; j < vars[course1][fieldType].size(); j++) {
-      if ((fieldType == FieldType::segment &&
-           timetabler->data.segments[i].isIntersecting(
-               timetabler->data.segments[j])) ||
-          (fieldType == FieldType::slot &&
-           timetabler->data.slots[i].isIntersecting(
-               timetabler->data.slots[j]))) {
-        notIntersecting1.addClauses(~Clauses(vars[course2][fieldType][j]));
+  if (fieldType == FieldType::segment &&
+      !timetabler->data.segmentStartVars.empty()) {
+    return notIntersectingSegmentOrder(course1, course2);
+  }
+  const std::vector<std::vector<bool>> &intersections =
+      (fieldType == FieldType::segment) ? timetabler->data.segmentIntersections
+                                        : timetabler->data.slotIntersections;
+  Clauses result(context);
+  for (unsigned i = 0; i < index.getValueCount(fieldType); i++) {
+    if (!canHaveFieldValue(course1, fieldType, i)) {
+      continue;
+    }
+    Clauses hasFieldValue1(index.getVar(course1, fieldType, i), context);
+    Clauses notIntersecting1(context);
+    for (unsigned j = 0; j < index.getValueCount(fieldType); j++) {
+      if (intersections[i][j] && canHaveFieldValue(course2, fieldType, j)) {
+        notIntersecting1.addClauses(
+            ~Clauses(index.getVar(course2, fieldType, j)));
       }
     }
     result.addClauses(hasFieldValue1 >> notIntersecting1);
@@ -184,6 +229,42 @@ Clauses ConstraintEncoder::notIntersectingTimeField(int course1, int course2,
   return result;
 }
 
+/**
+ * @brief      Gives Clauses that represent that a pair of courses cannot have
+ * intersecting Segments, using the segment order variables.
+ *
+ * Two Segments do not intersect if one ends before the other starts, which
+ * holds if there is a segment unit k such that the first Segment does not end
+ * after k and the second Segment starts after k. This needs a single clause
+ * over the definitions of these conjunctions, whose size is linear in the
+ * number of segment units, instead of a clause for every possible Segment of
+ * the first Course. The order variables are only defined by the Segment of a
+ * Course in one direction, so these clauses must not be negated.
+ *
+ * @param[in]  course1  The course 1
+ * @param[in]  course2  The course 2
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::notIntersectingSegmentOrder(int course1,
+                                                       int course2) {
+  const std::vector<Var> &start1 = timetabler->data.segmentStartVars[course1];
+  const std::vector<Var> &end1 = timetabler->data.segmentEndVars[course1];
+  const std::vector<Var> &start2 = timetabler->data.segmentStartVars[course2];
+  const std::vector<Var> &end2 = timetabler->data.segmentEndVars[course2];
+  CClause resultClause;
+  for (unsigned k = 0; k < start1.size(); k++) {
+    // the Segment of course1 is before the one of course2
+    resultClause.addLits(context->defineConjunction(
+        {~mkLit(end1[k], false), mkLit(start2[k], false)}));
+    // the Segment of course2 is before the one of course1
+    resultClause.addLits(context->defineConjunction(
+        {~mkLit(end2[k], false), mkLit(start1[k], false)}));
+  }
+  Clauses result(resultClause, context);
+  return result;
+}
+
 /**
  * @brief      Gives Clauses that represent that a Course can have exactly
  *             one field value of a given FieldType to be True.
@@ -191,15 +272,19 @@ Clauses ConstraintEncoder::notIntersectingTimeField(int course1, int course2,
  * This is helpful for defining constraints such as that that a given
  * Course must have exactly one Instructor.
  *
- * @param[in]  course     The course
- * @param[in]  fieldType  The field type
+ * @param[in]  course        The course
+ * @param[in]  fieldType     The field type
+ * @param[in]  onlyPositive  Whether the clauses are only required to hold, and
+ * are never negated, see hasAtMostOneFieldValueTrue
  *
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::hasExactlyOneFieldValueTrue(int course,
-                                                       FieldType fieldType) {
+                                                       FieldType fieldType,
+                                                       bool onlyPositive) {
   Clauses atLeastOne = Clauses(hasAtLeastOneFieldValueTrue(course, fieldType));
-  Clauses atMostOne = Clauses(hasAtMostOneFieldValueTrue(course, fieldType));
+  Clauses atMostOne =
+      Clauses(hasAtMostOneFieldValueTrue(course, fieldType, onlyPositive));
   return (atLeastOne & atMostOne);
 }
 
@@ -219,7 +304,7 @@ Clauses ConstraintEncoder::hasAtLeastOneFieldValueTrue(int course,
   for (unsigned i = 0; i < varsToUse.size(); i++) {
     resultClause.createLitAndAdd(varsToUse[i]);
   }
-  Clauses result(resultClause);
+  Clauses result(resultClause, context);
   return result;
 }
 
@@ -227,41 +312,79 @@ Clauses ConstraintEncoder::hasAtLeastOneFieldValueTrue(int course,
  * @brief      Gives Clauses that represent that a Course can have
  *             at most one field value of a given FieldType to be True.
  *
- * The binomial encoding has been used to represent this constraint. A more
- * efficient encoding, with auxiliary variables, has not been used because
- * such an encoding would only be equisatisfiable. However, when using these
- * clauses as an antecedent of an implication, we need that if the antecedent
- * of the encoded clauses is False, the original set of clauses would also
- * have been False, a property that equisatifiability does not guarantee.
+ * By default, the binomial encoding is used. An encoding with auxiliary
+ * variables would only be equisatisfiable. When using these clauses as an
+ * antecedent of an implication, or negating them otherwise, we need that if
+ * the encoded clauses are False, the original set of clauses would also have
+ * been False, a property that equisatisfiability does not guarantee.
  *
- * @param[in]  course     The course
- * @param[in]  fieldType  The field type
+ * If the clauses are only required to hold, as in the consequent of an
+ * implication that is itself required to hold, the encoding given by
+ * Data::amoEncoding is used instead.
+ *
+ * @param[in]  course        The course
+ * @param[in]  fieldType     The field type
+ * @param[in]  onlyPositive  Whether the clauses are only required to hold, and
+ * are never negated
  *
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::hasAtMostOneFieldValueTrue(int course,
+                                                      FieldType fieldType,
+                                                      bool onlyPositive) {
+  std::vector<Lit> lits = getFieldValueLits(course, fieldType);
+  if (!onlyPositive) {
+    return context->atMostK(lits, 1, AMOEncoding::binomial);
+  }
+  return atMostK(lits, 1);
+}
+
+/**
+ * @brief      Gives the literals of the field values of a FieldType that a
+ * Course can have.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ *
+ * @return     The literals
+ */
+std::vector<Lit> ConstraintEncoder::getFieldValueLits(int course,
                                                       FieldType fieldType) {
-  std::vector<Var> varsToUse = getAllowedVars(course, fieldType);
-  Clauses result;
-  for (unsigned i = 0; i < vars[course][fieldType].size(); i++) {
-    for (unsigned j = i + 1; j < vars[course][fieldType].size(); j++) {
-      Clauses first(vars[course][fieldType][i]);
-      Clauses second(vars[course][fieldType][j]);
-      Clauses negSecond = ~second;
-      result.addClauses(~first | negSecond);
+  std::vector<Lit> lits;
+  for (unsigned i = 0; i < index.getValueCount(fieldType); i++) {
+    if (canHaveFieldValue(course, fieldType, i)) {
+      lits.push_back(mkLit(index.getVar(course, fieldType, i), false));
     }
   }
-  return result;
+  return lits;
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most k of the given
+ * literals are True.
+ *
+ * For k = 1, the encoding given by Data::amoEncoding is used, see
+ * EncodingContext::atMostK. As these encodings use auxiliary variables,
+ * these clauses must not be negated. They can be guarded, see
+ * Timetabler::addGuardedClauses.
+ *
+ * @param[in]  lits  The literals
+ * @param[in]  k     The maximum number of True literals
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::atMostK(const std::vector<Lit> &lits, unsigned k) {
+  return context->atMostK(lits, k, timetabler->data.amoEncoding);
 }
 
 /**
  * @brief      Gets a vector of Var that are to be considered for a given
  *             FieldType when defining constraints for that FieldType.
  *
- * This is useful for the case of Classroom, where variables which represent
- * classrooms with size smaller than the class size of a Course are not
- * considered for that Course. For other FieldType values, all variables
- * are returned.
+ * Field values that the Course cannot have are never returned. This includes
+ * classrooms with size smaller than the class size of a Course, which are
+ * forbidden by the domain store, unless the Course is fixed to such a
+ * Classroom, in which case its variable is still not returned.
  *
  * @param[in]  course     The course
  * @param[in]  fieldType  The field type
@@ -272,14 +395,14 @@ std::vector<Var> ConstraintEncoder::getAllowedVars(int course,
                                                    FieldType fieldType) {
   std::vector<Var> varsToUse;
   varsToUse.clear();
-  if (fieldType != FieldType::classroom) {
-    varsToUse = vars[course][fieldType];
-  } else {
-    for (unsigned i = 0; i < vars[course][fieldType].size(); i++) {
-      if (timetabler->data.courses[course].getClassSize() <=
-          timetabler->data.classrooms[i].getSize()) {
-        varsToUse.push_back(vars[course][fieldType][i]);
-      }
+  for (unsigned i = 0; i < index.getValueCount(fieldType); i++) {
+    if (!canHaveFieldValue(course, fieldType, i)) {
+      continue;
+    }
+    if (fieldType != FieldType::classroom ||
+        timetabler->data.courses[course].getClassSize() <=
+            timetabler->data.classrooms[i].getSize()) {
+      varsToUse.push_back(index.getVar(course, fieldType, i));
     }
   }
   return varsToUse;
@@ -294,8 +417,12 @@ std::vector<Var> ConstraintEncoder::getAllowedVars(int course,
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::isMinorCourse(int course) {
-  Clauses result(vars[course][FieldType::isMinor]
-                     [static_cast<unsigned>(MinorType::isMinorCourse)]);
+  const int isMinorValue = static_cast<int>(MinorType::isMinorCourse);
+  if (!canHaveFieldValue(course, FieldType::isMinor, isMinorValue)) {
+    return Clauses(CClause(), context);
+  }
+  Clauses result(index.getVar(course, FieldType::isMinor, isMinorValue),
+                 context);
   return result;
 }
 
@@ -309,12 +436,13 @@ Clauses ConstraintEncoder::isMinorCourse(int course) {
  */
 Clauses ConstraintEncoder::slotInMinorTime(int course) {
   CClause resultClause;
-  for (unsigned i = 0; i < vars[course][FieldType::slot].size(); i++) {
-    if (timetabler->data.slots[i].isMinorSlot()) {
-      resultClause.createLitAndAdd(vars[course][FieldType::slot][i]);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::slot); i++) {
+    if (timetabler->data.slots[i].isMinorSlot() &&
+        canHaveFieldValue(course, FieldType::slot, i)) {
+      resultClause.createLitAndAdd(index.getVar(course, FieldType::slot, i));
     }
   }
-  Clauses result(resultClause);
+  Clauses result(resultClause, context);
   return result;
 }
 
@@ -327,12 +455,13 @@ Clauses ConstraintEncoder::slotInMinorTime(int course) {
  */
 Clauses ConstraintEncoder::isCoreCourse(int course) {
   CClause resultClause;
-  for (unsigned i = 0; i < vars[course][FieldType::program].size(); i++) {
-    if (timetabler->data.programs[i].isCoreProgram()) {
-      resultClause.createLitAndAdd(vars[course][FieldType::program][i]);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::program); i++) {
+    if (timetabler->data.programs[i].isCoreProgram() &&
+        canHaveFieldValue(course, FieldType::program, i)) {
+      resultClause.createLitAndAdd(index.getVar(course, FieldType::program, i));
     }
   }
-  Clauses result(resultClause);
+  Clauses result(resultClause, context);
   return result;
 }
 
@@ -345,12 +474,13 @@ Clauses ConstraintEncoder::isCoreCourse(int course) {
  */
 Clauses ConstraintEncoder::isElectiveCourse(int course) {
   CClause resultClause;
-  for (unsigned i = 0; i < vars[course][FieldType::program].size(); i++) {
-    if (!(timetabler->data.programs[i].isCoreProgram())) {
-      resultClause.createLitAndAdd(vars[course][FieldType::program][i]);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::program); i++) {
+    if (!(timetabler->data.programs[i].isCoreProgram()) &&
+        canHaveFieldValue(course, FieldType::program, i)) {
+      resultClause.createLitAndAdd(index.getVar(course, FieldType::program, i));
     }
   }
-  Clauses result(resultClause);
+  Clauses result(resultClause, context);
   return result;
 }
 
@@ -364,12 +494,13 @@ Clauses ConstraintEncoder::isElectiveCourse(int course) {
  */
 Clauses ConstraintEncoder::courseInMorningTime(int course) {
   CClause resultClause;
-  for (unsigned i = 0; i < vars[course][FieldType::slot].size(); i++) {
-    if (timetabler->data.slots[i].isMorningSlot()) {
-      resultClause.createLitAndAdd(vars[course][FieldType::slot][i]);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::slot); i++) {
+    if (timetabler->data.slots[i].isMorningSlot() &&
+        canHaveFieldValue(course, FieldType::slot, i)) {
+      resultClause.createLitAndAdd(index.getVar(course, FieldType::slot, i));
     }
   }
-  Clauses result(resultClause);
+  Clauses result(resultClause, context);
   return result;
 }
 
@@ -383,12 +514,17 @@ Clauses ConstraintEncoder::courseInMorningTime(int course) {
  * @return     A Clauses object representing the condition
  */
 Clauses ConstraintEncoder::programAtMostOneOfCoreOrElective(int course) {
-  Clauses result;
-  for (unsigned i = 0; i < vars[course][FieldType::program].size(); i += 2) {
+  Clauses result(context);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::program); i += 2) {
+    if (!canHaveFieldValue(course, FieldType::program, i) ||
+        !canHaveFieldValue(course, FieldType::program, i + 1)) {
+      continue;
+    }
     CClause resultClause;
-    resultClause.addLits(~mkLit(vars[course][FieldType::program][i], false));
     resultClause.addLits(
-        ~mkLit(vars[course][FieldType::program][i + 1], false));
+        ~mkLit(index.getVar(course, FieldType::program, i), false));
+    resultClause.addLits(
+        ~mkLit(index.getVar(course, FieldType::program, i + 1), false));
     result.addClauses(resultClause);
   }
   return result;
@@ -398,7 +534,9 @@ Clauses ConstraintEncoder::programAtMostOneOfCoreOrElective(int course) {
  * @brief      Gives Clauses that represent that a Course has a field
  *             value for a given FieldType out of a list of possible values.
  *
- * This is useful for encoding custom constraints.
+ * This is useful for encoding custom constraints. The listed values are
+ * recorded in Data::listedValues, as they are no longer interchangeable with
+ * other values.
  *
  * @param[in]  course     The course
  * @param[in]  fieldType  The field type
@@ -409,10 +547,291 @@ Clauses ConstraintEncoder::programAtMostOneOfCoreOrElective(int course) {
  */
 Clauses ConstraintEncoder::hasFieldTypeListedValues(
     int course, FieldType fieldType, std::vector<int> indexList) {
+  std::vector<bool> &listed = timetabler->data.listedValues[fieldType];
+  listed.resize(index.getValueCount(fieldType), false);
   CClause resultClause;
   for (unsigned i = 0; i < indexList.size(); i++) {
-    resultClause.createLitAndAdd(vars[course][fieldType][indexList[i]]);
+    listed[indexList[i]] = true;
+    if (canHaveFieldValue(course, fieldType, indexList[i])) {
+      resultClause.createLitAndAdd(
+          index.getVar(course, fieldType, indexList[i]));
+    }
+  }
+  Clauses result(resultClause, context);
+  return result;
+}
+
+/**
+ * @brief      Gets the literals of the listed field values of a FieldType for
+ * a list of Courses.
+ *
+ * As a Course has exactly one field value of the FieldType, the number of
+ * True literals is the number of Courses that have one of the listed values,
+ * which can then be limited with atMostK. The listed values are recorded in
+ * Data::listedValues, see hasFieldTypeListedValues.
+ *
+ * @param[in]  courses    The indices of the courses
+ * @param[in]  fieldType  The field type
+ * @param[in]  indexList  A vector of indices of the data corresponding to the
+ *                        FieldType for the listed field values of the type.
+ *
+ * @return     The literals
+ */
+std::vector<Lit> ConstraintEncoder::getListedValueLits(
+    const std::vector<int> &courses, FieldType fieldType,
+    const std::vector<int> &indexList) {
+  std::vector<bool> &listed = timetabler->data.listedValues[fieldType];
+  listed.resize(index.getValueCount(fieldType), false);
+  std::vector<Lit> result;
+  for (unsigned i = 0; i < indexList.size(); i++) {
+    listed[indexList[i]] = true;
+    for (unsigned j = 0; j < courses.size(); j++) {
+      if (canHaveFieldValue(courses[j], fieldType, indexList[i])) {
+        result.push_back(
+            mkLit(index.getVar(courses[j], fieldType, indexList[i]), false));
+      }
+    }
   }
-  Clauses result(resultClause);
   return result;
 }
+
+/**
+ * @brief      Gives Clauses that represent that the occupancy variables of a
+ * Course are True for every time atom covered by its Slot and Segment.
+ *
+ * Auxiliary variables are created for each time period and each segment unit
+ * of the Course, which are implied by the Slots and Segments that cover them.
+ * An occupancy variable is then implied by the conjunction of the variables of
+ * its time period and segment unit. Only this direction is encoded, as the
+ * occupancy variables are only ever used negatively, so the clauses can always
+ * be added as hard clauses.
+ *
+ * @param[in]  course  The course
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::occupiesTimeAtoms(int course) {
+  Data &data = timetabler->data;
+  std::vector<Lit> periodLits, unitLits;
+  for (unsigned i = 0; i < data.periodCount; i++) {
+    periodLits.push_back(context->newLiteral());
+  }
+  for (unsigned i = 0; i < data.segmentUnitCount; i++) {
+    unitLits.push_back(context->newLiteral());
+  }
+  Clauses result(context);
+  for (unsigned i = 0; i < index.getValueCount(FieldType::slot); i++) {
+    if (!canHaveFieldValue(course, FieldType::slot, i)) {
+      continue;
+    }
+    for (unsigned period : data.slotPeriods[i]) {
+      CClause resultClause;
+      resultClause.addLits(
+          ~mkLit(index.getVar(course, FieldType::slot, i), false),
+          periodLits[period]);
+      result.addClauses(resultClause);
+    }
+  }
+  for (unsigned i = 0; i < index.getValueCount(FieldType::segment); i++) {
+    if (!canHaveFieldValue(course, FieldType::segment, i)) {
+      continue;
+    }
+    for (unsigned unit : data.segmentUnits[i]) {
+      CClause resultClause;
+      resultClause.addLits(
+          ~mkLit(index.getVar(course, FieldType::segment, i), false),
+          unitLits[unit]);
+      result.addClauses(resultClause);
+    }
+  }
+  for (unsigned i = 0; i < data.periodCount; i++) {
+    for (unsigned j = 0; j < data.segmentUnitCount; j++) {
+      CClause resultClause;
+      resultClause.addLits(
+          ~periodLits[i], ~unitLits[j],
+          mkLit(data.occupancyVars[course][i * data.segmentUnitCount + j],
+                false));
+      result.addClauses(resultClause);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Gives Clauses that represent that the segment order variables of
+ * a Course are consistent with its Segment.
+ *
+ * The start variables and the end variables each form a ladder, where a
+ * Segment starting after the segment unit k + 1 also starts after k. A
+ * Segment from the unit i to the unit j implies that the Segment starts after
+ * i - 1 but not after i, and ends after j - 1 but not after j. If a Course has
+ * a single Segment, this fixes all of its order variables. The clauses only
+ * have to hold, so they can always be added as hard clauses.
+ *
+ * @param[in]  course  The course
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::segmentOrderDefinitions(int course) {
+  Data &data = timetabler->data;
+  const std::vector<Var> &startVars = data.segmentStartVars[course];
+  const std::vector<Var> &endVars = data.segmentEndVars[course];
+  Clauses result(context);
+  for (unsigned k = 0; k + 1 < startVars.size(); k++) {
+    CClause startClause, endClause;
+    startClause.addLits(~mkLit(startVars[k + 1], false),
+                        mkLit(startVars[k], false));
+    endClause.addLits(~mkLit(endVars[k + 1], false), mkLit(endVars[k], false));
+    result.addClauses(startClause);
+    result.addClauses(endClause);
+  }
+  for (unsigned i = 0; i < index.getValueCount(FieldType::segment); i++) {
+    if (!canHaveFieldValue(course, FieldType::segment, i)) {
+      continue;
+    }
+    Lit segment = mkLit(index.getVar(course, FieldType::segment, i), false);
+    unsigned first = data.segmentUnits[i].front();
+    unsigned last = data.segmentUnits[i].back();
+    std::vector<Lit> implied;
+    if (first > 0) {
+      implied.push_back(mkLit(startVars[first - 1], false));
+    }
+    if (first < startVars.size()) {
+      implied.push_back(~mkLit(startVars[first], false));
+    }
+    if (last > 0) {
+      implied.push_back(mkLit(endVars[last - 1], false));
+    }
+    if (last < endVars.size()) {
+      implied.push_back(~mkLit(endVars[last], false));
+    }
+    for (Lit lit : implied) {
+      CClause resultClause;
+      resultClause.addLits(~segment, lit);
+      result.addClauses(resultClause);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Gives Clauses that break the symmetry between interchangeable
+ * field values of a FieldType.
+ *
+ * The values must be interchangeable, so that swapping any two of them maps
+ * every solution to a solution with the same cost. Every solution can then be
+ * mapped to one where the values are first used in their order, as given by
+ * the courses in their order. That is, a Course can only have the value t
+ * if the value t - 1 is had by the Course or an earlier one. The auxiliary
+ * literal u(c, t) can only be True if the value t is had by the Course c or an
+ * earlier one, which keeps the size linear in the number of courses and
+ * values. Courses that cannot have the values are skipped. As this uses
+ * auxiliary variables, these clauses must not be negated.
+ *
+ * @param[in]  fieldType  The field type
+ * @param[in]  values     The indices of the interchangeable field values, in
+ * the order in which they are to be first used
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::valuePrecedence(FieldType fieldType,
+                                           const std::vector<int> &values) {
+  Clauses result(context);
+  // the literals u(c, t) of the previous Course, lit_Undef before any Course
+  std::vector<Lit> previousUsed(values.size(), lit_Undef);
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    if (!canHaveFieldValue(i, fieldType, values[0])) {
+      continue;
+    }
+    std::vector<Lit> used(values.size(), lit_Undef);
+    for (unsigned t = 0; t < values.size(); t++) {
+      Lit field = mkLit(index.getVar(i, fieldType, values[t]), false);
+      if (t > 0) {
+        CClause precedenceClause;
+        precedenceClause.addLits(~field, used[t - 1]);
+        result.addClauses(precedenceClause);
+      }
+      if (t + 1 < values.size()) {
+        used[t] = context->newLiteral();
+        CClause usedClause;
+        usedClause.addLits(~used[t], field);
+        if (previousUsed[t] != lit_Undef) {
+          usedClause.addLits(previousUsed[t]);
+        }
+        result.addClauses(usedClause);
+      }
+    }
+    previousUsed = used;
+  }
+  return result;
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most one Course has a given
+ * field value of a FieldType while occupying a given time atom.
+ *
+ * For example, this can be used to represent that an Instructor teaches at
+ * most one course during a time atom. The sequential counter encoding is used
+ * over the courses that can have the field value, where the input of a Course
+ * is the conjunction of its field value variable and its occupancy variable.
+ * As this uses auxiliary variables, these clauses must not be negated.
+ *
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ * @param[in]  atom       The index of the time atom
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses ConstraintEncoder::fieldValueAtMostOneCourseInTimeAtom(
+    FieldType fieldType, int value, int atom) {
+  std::vector<int> courses;
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    if (canHaveFieldValue(i, fieldType, value)) {
+      courses.push_back(i);
+    }
+  }
+  Clauses result(context);
+  Lit previousCounter = lit_Undef;
+  for (unsigned i = 0; i < courses.size(); i++) {
+    Lit field = mkLit(index.getVar(courses[i], fieldType, value), false);
+    Lit occupied =
+        mkLit(timetabler->data.occupancyVars[courses[i]][atom], false);
+    if (i > 0) {
+      // no earlier course may have been counted already
+      CClause resultClause;
+      resultClause.addLits(~field, ~occupied, ~previousCounter);
+      result.addClauses(resultClause);
+    }
+    if (i + 1 < courses.size()) {
+      Lit counter = context->newLiteral();
+      CClause resultClause;
+      resultClause.addLits(~field, ~occupied, counter);
+      result.addClauses(resultClause);
+      if (i > 0) {
+        CClause propagateClause;
+        propagateClause.addLits(~previousCounter, counter);
+        result.addClauses(propagateClause);
+      }
+      previousCounter = counter;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Determines if a Course can have a given field value of a
+ * FieldType.
+ *
+ * A Course cannot have a field value if it is forbidden by the domain store,
+ * in which case no variable was added for it.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ *
+ * @return     True if the Course can have the field value, False otherwise
+ */
+bool ConstraintEncoder::canHaveFieldValue(int course, FieldType fieldType,
+                                          int value) {
+  return index.getVar(course, fieldType, value) != var_Undef;
+}
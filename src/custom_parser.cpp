@@ -54,6 +54,9 @@ Clauses makeAntecedent(Object &obj, int course) {
  */
 Clauses makeConsequent(Object &obj, int course, int i) {
   Clauses cons, clause;
+  if (obj.classSame || obj.classNotSame || obj.classValues.size() > 0) {
+    obj.timetabler->data.customClassroomConstraints = true;
+  }
   if (obj.classSame) {
     for (unsigned j = i + 1; j < obj.courseValues.size(); j++) {
       Clauses a = makeAntecedent(obj, obj.courseValues[j]);
@@ -123,6 +126,18 @@ struct action<integer> {
   }
 };
 
+/**
+ * @brief      Parse bound: Store the maximum number of courses in the object
+ */
+struct bound : pegtl::plus<pegtl::digit> {};
+template <>
+struct action<bound> {
+  template <typename Input>
+  static void apply(const Input &in, Object &obj) {
+    obj.bound = std::stoi(in.string());
+  }
+};
+
 /**
  * @brief      Parse "IN"
  */
@@ -257,6 +272,16 @@ struct bundlestr : TAO_PEGTL_KEYWORD("BUNDLE") {};
  */
 struct weightstr : TAO_PEGTL_KEYWORD("WEIGHT") {};
 
+/**
+ * @brief      Parse "AT"
+ */
+struct atstr : TAO_PEGTL_KEYWORD("AT") {};
+
+/**
+ * @brief      Parse "MOST"
+ */
+struct moststr : TAO_PEGTL_KEYWORD("MOST") {};
+
 /**
  * @brief      Constraint is on one of the instructor, segment, isminor,
  * program. isNot, classSame, slotSame, classNotSame, slotNotSame are reset.
@@ -571,10 +596,10 @@ struct action<constraint_unbundle> {
           obj.timetabler->newVar());
       int index = obj.timetabler->data.customConstraintVars.size() - 1;
       if (obj.integer != 0) {
-        Clauses hardConsequent =
-            CClause(obj.timetabler->data.customConstraintVars[index]) >>
-            obj.constraint;
-        obj.timetabler->addClauses(hardConsequent, -1);
+        obj.timetabler->addGuardedClauses(
+            obj.timetabler->getGuard(
+                obj.timetabler->data.customConstraintVars[index], obj.integer),
+            obj.constraint, -1);
       }
       obj.timetabler->data.customMap[index] = course;
       obj.timetabler->addHighLevelCustomConstraintClauses(index, obj.integer);
@@ -635,10 +660,10 @@ struct action<constraint_bundle> {
         obj.timetabler->newVar());
     int index = obj.timetabler->data.customConstraintVars.size() - 1;
     if (obj.integer != 0) {
-      Clauses hardConsequent =
-          CClause(obj.timetabler->data.customConstraintVars[index]) >>
-          obj.constraint;
-      obj.timetabler->addClauses(hardConsequent, -1);
+      obj.timetabler->addGuardedClauses(
+          obj.timetabler->getGuard(
+              obj.timetabler->data.customConstraintVars[index], obj.integer),
+          obj.constraint, -1);
     }
     obj.timetabler->addHighLevelCustomConstraintClauses(index, obj.integer);
 
@@ -657,13 +682,90 @@ struct action<constraint_bundle> {
   }
 };
 
+/**
+ * @brief      Parse the classrooms or slots of a capacity constraint, which
+ * must be listed, as "SAME" and "NOTSAME" do not give values to count
+ */
+struct capacitydecl
+    : pegtl::sor<
+          pegtl::seq<pegtl::pad<slotstr, pegtl::space>,
+                     pegtl::sor<allvalues, listvalues>>,
+          pegtl::seq<pegtl::pad<classroomstr, pegtl::space>,
+                     pegtl::sor<allvalues, listvalues>>> {};
+
+/**
+ * @brief      Parse a constraint that at most a number of courses have one of
+ * the listed classrooms or slots
+ */
+struct constraint_capacity
+    : pegtl::seq<coursedecl, pegtl::pad<atstr, pegtl::space>,
+                 pegtl::pad<moststr, pegtl::space>,
+                 pegtl::pad<bound, pegtl::space>,
+                 pegtl::pad<instr, pegtl::space>, capacitydecl,
+                 pegtl::pad<weightstr, pegtl::space>,
+                 pegtl::pad<integer, pegtl::space>> {};
+template <>
+struct action<constraint_capacity> {
+  template <typename Input>
+  static void apply(const Input &in, Object &obj) {
+    if (obj.courseExcept) {
+      std::vector<int> courseVals;
+      for (unsigned i = 0; i < obj.timetabler->data.courses.size(); i++) {
+        if (std::find(obj.courseValues.begin(), obj.courseValues.end(), i) ==
+            obj.courseValues.end()) {
+          courseVals.push_back(i);
+        }
+      }
+      obj.courseValues = courseVals;
+    }
+    // The courses are parsed again by every alternative that is tried first,
+    // and each course must be counted once
+    std::sort(obj.courseValues.begin(), obj.courseValues.end());
+    obj.courseValues.erase(
+        std::unique(obj.courseValues.begin(), obj.courseValues.end()),
+        obj.courseValues.end());
+    std::vector<Lit> lits;
+    if (obj.classValues.size() > 0) {
+      obj.timetabler->data.customClassroomConstraints = true;
+      lits = obj.constraintEncoder->getListedValueLits(
+          obj.courseValues, FieldType::classroom, obj.classValues);
+    } else {
+      lits = obj.constraintEncoder->getListedValueLits(
+          obj.courseValues, FieldType::slot, obj.slotValues);
+    }
+
+    obj.timetabler->data.customConstraintVars.push_back(
+        obj.timetabler->newVar());
+    int index = obj.timetabler->data.customConstraintVars.size() - 1;
+    obj.timetabler->addCardinality(
+        lits, obj.bound, obj.timetabler->data.customConstraintVars[index],
+        obj.integer);
+    obj.timetabler->addHighLevelCustomConstraintClauses(index, obj.integer);
+
+    obj.courseValues.clear();
+    obj.instructorValues.clear();
+    obj.isMinorValues.clear();
+    obj.programValues.clear();
+    obj.segmentValues.clear();
+    obj.classValues.clear();
+    obj.slotValues.clear();
+    obj.isNot = false;
+    obj.classSame = false;
+    obj.slotSame = false;
+    obj.classNotSame = false;
+    obj.slotNotSame = false;
+    obj.bound = 0;
+  }
+};
+
 /**
  * @brief      Parse constraints from the file, generate error on failure
  */
 struct grammar
-    : pegtl::try_catch<
-          pegtl::must<pegtl::star<pegtl::sor<constraint_bundle, constraint_unbundle>>,
-                      pegtl::eof>> {};
+    : pegtl::try_catch<pegtl::must<
+          pegtl::star<pegtl::sor<constraint_bundle, constraint_unbundle,
+                                 constraint_capacity>>,
+          pegtl::eof>> {};
 
 template <typename Rule>
 struct control : pegtl::normal<Rule> {
@@ -704,4 +806,5 @@ Object::Object() {
   slotSame = false;
   classNotSame = false;
   slotNotSame = false;
+  bound = 0;
 }
@@ -1,5 +1,6 @@
 #include "data.h"
 
+#include <chrono>
 #include "global.h"
 
 /**
@@ -17,4 +18,21 @@ Data::Data() {
   existingAssignmentWeights[FieldType::instructor] = -1;
   predefinedClausesWeights[PredefinedClauses::coreInMorningTime] = 1;
   predefinedClausesWeights[PredefinedClauses::electiveInNonMorningTime] = 1;
+  timeEncoding = TimeEncoding::pairwise;
+  threadCount = 1;
+  amoEncoding = AMOEncoding::sequential;
+  portfolio.assign(1, SolverConfiguration::stratified);
+  segmentEncoding = SegmentEncoding::interval;
+  keepSegmentLength = false;
+  symmetryBreaking = true;
+  directHardConstraints = false;
+  relaxHardConstraints = false;
+  session = false;
+  matchClassrooms = false;
+  customClassroomConstraints = false;
+  deadline = std::chrono::steady_clock::time_point::max();
+  progressFd = -1;
+  listedValues.resize(Global::FIELD_COUNT);
+  periodCount = 0;
+  segmentUnitCount = 0;
 }
\ No newline at end of file
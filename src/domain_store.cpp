@@ -0,0 +1,79 @@
+#include "domain_store.h"
+
+#include <vector>
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Clears the domain store, which makes all values free.
+ */
+void DomainStore::clear() { values.clear(); }
+
+/**
+ * @brief      Records the state of a field value of a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ * @param[in]  state      l_True if the value is fixed, l_False if it is
+ * forbidden, and l_Undef if it is free
+ */
+void DomainStore::setValue(int course, FieldType fieldType, int value,
+                           lbool state) {
+  if (values.size() <= static_cast<unsigned>(course)) {
+    values.resize(course + 1,
+                  std::vector<std::vector<lbool>>(Global::FIELD_COUNT));
+  }
+  std::vector<lbool> &fieldValues = values[course][fieldType];
+  if (fieldValues.size() <= static_cast<unsigned>(value)) {
+    fieldValues.resize(value + 1, l_Undef);
+  }
+  fieldValues[value] = state;
+}
+
+/**
+ * @brief      Gets the state of a field value of a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ *
+ * @return     l_True if the value is fixed, l_False if it is forbidden, and
+ * l_Undef if it is free
+ */
+lbool DomainStore::getValue(int course, FieldType fieldType, int value) const {
+  if (static_cast<unsigned>(course) >= values.size() ||
+      static_cast<unsigned>(value) >= values[course][fieldType].size()) {
+    return l_Undef;
+  }
+  return values[course][fieldType][value];
+}
+
+/**
+ * @brief      Determines if a field value is forbidden for a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ *
+ * @return     True if the value is forbidden, False otherwise
+ */
+bool DomainStore::isForbidden(int course, FieldType fieldType,
+                              int value) const {
+  return getValue(course, fieldType, value) == l_False;
+}
+
+/**
+ * @brief      Determines if a field value is fixed to True for a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ *
+ * @return     True if the value is fixed, False otherwise
+ */
+bool DomainStore::isFixed(int course, FieldType fieldType, int value) const {
+  return getValue(course, fieldType, value) == l_True;
+}
@@ -0,0 +1,513 @@
+#include "encoding_context.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "cclause.h"
+#include "clause_sink.h"
+#include "clauses.h"
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the EncodingContext object.
+ *
+ * The EncodingContext takes ownership of the ClauseSink.
+ *
+ * @param      sink      The clause sink to which all clauses are added
+ * @param[in]  firstVar  The first variable to be issued
+ */
+EncodingContext::EncodingContext(ClauseSink *sink, Var firstVar) {
+  this->sink = sink;
+  vars = firstVar;
+  softWeight = 0;
+}
+
+/**
+ * @brief      Sets the ClauseSink to which all clauses are added.
+ *
+ * The EncodingContext takes ownership of the ClauseSink, and the previous
+ * ClauseSink is destroyed.
+ *
+ * @param      sink  The clause sink
+ */
+void EncodingContext::setClauseSink(ClauseSink *sink) {
+  delete this->sink;
+  this->sink = sink;
+}
+
+/**
+ * @brief      Issues a new variable and returns it.
+ *
+ * @return     The new Var
+ */
+Var EncodingContext::newVar() { return vars++; }
+
+/**
+ * @brief      Issues a new literal and returns it.
+ *
+ * @param[in]  sign  The sign, whether the literal contains a sign with the
+ * variable
+ *
+ * @return     The Lit corresponding to the new Var
+ */
+Lit EncodingContext::newLiteral(bool sign) { return mkLit(newVar(), sign); }
+
+/**
+ * @brief      Gets the number of variables issued so far.
+ *
+ * @return     The number of variables
+ */
+int EncodingContext::nVars() const { return vars; }
+
+/**
+ * @brief      Gives a literal that is equivalent to a given clause.
+ *
+ * The literal of a unit clause is the literal itself. Otherwise, a new literal
+ * c is created and recorded as defined by (c <-> clause). The clauses of the
+ * definition are added only when c is used in a clause added to the formula,
+ * see addDefinitionPolarity. The definitions are cached on the sorted literals
+ * of the clause, so a clause that has already been defined reuses its literal.
+ *
+ * @param[in]  lits  Pointer to the first literal of the clause
+ * @param[in]  size  The number of literals in the clause
+ *
+ * @return     The literal equivalent to the clause
+ */
+Lit EncodingContext::defineClause(const Lit *lits, unsigned size) {
+  std::vector<Lit> key(lits, lits + size);
+  std::sort(key.begin(), key.end());
+  key.erase(std::unique(key.begin(), key.end()), key.end());
+  if (key.size() == 1) {
+    return key[0];
+  }
+  auto it = clauseDefinitions.find(key);
+  if (it != clauseDefinitions.end()) {
+    return it->second;
+  }
+  Lit c = addDefinition(false, key);
+  clauseDefinitions.emplace(std::move(key), c);
+  return c;
+}
+
+/**
+ * @brief      Gives a literal that is equivalent to the conjunction of the
+ * given literals.
+ *
+ * The literal of a single literal is the literal itself. Otherwise, a new
+ * literal x is created and recorded as defined by (x <-> conjunction). As in
+ * defineClause, the clauses of the definition are added lazily, and the
+ * definitions are cached.
+ *
+ * @param[in]  lits  The literals
+ *
+ * @return     The literal equivalent to the conjunction
+ */
+Lit EncodingContext::defineConjunction(std::vector<Lit> lits) {
+  std::sort(lits.begin(), lits.end());
+  lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+  if (lits.size() == 1) {
+    return lits[0];
+  }
+  auto it = conjunctionDefinitions.find(lits);
+  if (it != conjunctionDefinitions.end()) {
+    return it->second;
+  }
+  Lit x = addDefinition(true, lits);
+  conjunctionDefinitions.emplace(std::move(lits), x);
+  return x;
+}
+
+/**
+ * @brief      Creates a new literal, and records its definition as a
+ * conjunction or a disjunction of the given literals, without adding any
+ * clauses.
+ *
+ * @param[in]  isConjunction  Whether the definition is a conjunction
+ * @param[in]  lits           The literals
+ *
+ * @return     The new literal
+ */
+Lit EncodingContext::addDefinition(bool isConjunction,
+                                   const std::vector<Lit> &lits) {
+  Lit p = newLiteral();
+  if (definitionIndex.size() <= static_cast<unsigned>(var(p))) {
+    definitionIndex.resize(var(p) + 1, -1);
+  }
+  definitionIndex[var(p)] = definitions.size();
+  Definition definition;
+  definition.isConjunction = isConjunction;
+  definition.lits = lits;
+  definition.positiveAdded = false;
+  definition.negativeAdded = false;
+  definitions.push_back(definition);
+  return p;
+}
+
+/**
+ * @brief      Adds the clauses of a definition that are needed for a given
+ * literal of the defined variable to appear in a clause of the formula.
+ *
+ * This is the Plaisted-Greenbaum encoding. If a defined variable v appears
+ * positively, only (v -> definition) is needed, and if it appears negatively,
+ * only (definition -> v) is needed. Each of these is added at most once, and
+ * the literals of the definition are in turn handled in the same way when
+ * these clauses are added. Literals that are not defined are ignored.
+ *
+ * @param[in]  lit   The literal
+ */
+void EncodingContext::addDefinitionPolarity(Lit lit) {
+  if (static_cast<unsigned>(var(lit)) >= definitionIndex.size() ||
+      definitionIndex[var(lit)] < 0) {
+    return;
+  }
+  Definition &definition = definitions[definitionIndex[var(lit)]];
+  bool positive = !sign(lit);
+  bool &added = positive ? definition.positiveAdded : definition.negativeAdded;
+  if (added) {
+    return;
+  }
+  added = true;
+  // the clauses contain ~lit, which is the polarity being defined, so only
+  // the literals of the definition need their own definitions
+  std::vector<Lit> literals;
+  literals.reserve(definition.lits.size());
+  for (const Lit &l : definition.lits) {
+    literals.push_back(positive ? l : ~l);
+    addDefinitionPolarity(literals.back());
+  }
+  if (definition.isConjunction == positive) {
+    // v -> (l1 AND l2 ...), or ~v -> (~l1 AND ~l2 ...) for a disjunction
+    for (const Lit &l : literals) {
+      Lit clause[] = {~lit, l};
+      sink->addClause(clause, 2, -1);
+    }
+  } else {
+    // v -> (l1 OR l2 ...), or ~v -> (~l1 OR ~l2 ...) for a conjunction
+    literals.push_back(~lit);
+    sink->addClause(literals.data(), literals.size(), -1);
+  }
+}
+
+/**
+ * @brief      Adds a clause to the ClauseSink, along with the definitions
+ * needed by its literals.
+ *
+ * All clauses of the encoding go through this function. A negative weight
+ * implies that the clause is hard, and a zero weight implies that the clause
+ * is dropped.
+ *
+ * @param[in]  lits    Pointer to the first literal of the clause
+ * @param[in]  size    The number of literals in the clause
+ * @param[in]  weight  The weight
+ */
+void EncodingContext::addClause(const Lit *lits, unsigned size,
+                                int64_t weight) {
+  if (weight == 0) {
+    return;
+  }
+  for (unsigned i = 0; i < size; i++) {
+    addDefinitionPolarity(lits[i]);
+  }
+  if (weight > 0) {
+    softWeight += weight;
+  }
+  sink->addClause(lits, size, weight);
+}
+
+/**
+ * @brief      Adds clauses that must hold only if a guard variable is True.
+ *
+ * This is equivalent to adding (guard -> clauses), but instead of encoding the
+ * implication with auxiliary variables, the negation of the guard is added to
+ * every clause. If the guard is var_Undef, the clauses are added as they are.
+ *
+ * @param[in]  guard    The guard variable
+ * @param[in]  clauses  The clauses
+ * @param[in]  weight   The weight
+ */
+void EncodingContext::addGuardedClauses(const Var &guard,
+                                        const Clauses &clauses, int weight) {
+  if (guard == var_Undef) {
+    for (unsigned i = 0; i < clauses.size(); i++) {
+      ClauseView clause = clauses.getClause(i);
+      addClause(clause.begin(), clause.size(), weight);
+    }
+    return;
+  }
+  for (unsigned i = 0; i < clauses.size(); i++) {
+    ClauseView clause = clauses.getClause(i);
+    clauseBuffer.assign(clause.begin(), clause.end());
+    clauseBuffer.push_back(mkLit(guard, true));
+    addClause(clauseBuffer.data(), clauseBuffer.size(), weight);
+  }
+}
+
+/**
+ * @brief      Adds the clauses encoded by a worker EncodingContext into a
+ * BufferClauseSink to this EncodingContext.
+ *
+ * The variables issued by the worker, which are in [firstVar, endVar), are
+ * replaced by new variables of this EncodingContext, in the same order. Other
+ * variables, such as the field value variables, are shared and are kept as
+ * they are.
+ *
+ * @param[in]  buffer    The clauses of the worker
+ * @param[in]  firstVar  The first variable issued by the worker
+ * @param[in]  endVar    The variable the worker would have issued next
+ */
+void EncodingContext::addBufferedClauses(const BufferClauseSink &buffer,
+                                         Var firstVar, Var endVar) {
+  Var offset = vars - firstVar;
+  for (Var v = firstVar; v < endVar; v++) {
+    newVar();
+  }
+  for (unsigned i = 0; i < buffer.size(); i++) {
+    const Lit *lits = buffer.getClause(i);
+    clauseBuffer.assign(lits, lits + buffer.getClauseSize(i));
+    for (Lit &lit : clauseBuffer) {
+      if (var(lit) >= firstVar) {
+        lit = mkLit(var(lit) + offset, sign(lit));
+      }
+    }
+    addClause(clauseBuffer.data(), clauseBuffer.size(), buffer.getWeight(i));
+  }
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most k of the given
+ * literals are True.
+ *
+ * For k = 1, the given encoding is used, and otherwise a totalizer is used.
+ * As these encodings use auxiliary variables, these clauses must not be
+ * negated, except for the binomial encoding. They can be guarded, see
+ * addGuardedClauses.
+ *
+ * @param[in]  lits         The literals
+ * @param[in]  k            The maximum number of True literals
+ * @param[in]  amoEncoding  The encoding used for k = 1
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses EncodingContext::atMostK(const std::vector<Lit> &lits, unsigned k,
+                                 AMOEncoding amoEncoding) {
+  Clauses result(this);
+  if (lits.size() <= k) {
+    return result;
+  }
+  if (k == 0) {
+    for (unsigned i = 0; i < lits.size(); i++) {
+      CClause resultClause;
+      resultClause.addLits(~lits[i]);
+      result.addClauses(resultClause);
+    }
+    return result;
+  }
+  if (k == 1) {
+    switch (amoEncoding) {
+      case AMOEncoding::sequential:
+        return atMostOneSequential(lits);
+      case AMOEncoding::product:
+        return atMostOneProduct(lits);
+      default:
+        return atMostOneBinomial(lits);
+    }
+  }
+  std::vector<Lit> outputs = totalizer(lits, 0, lits.size(), k + 1, result);
+  CClause resultClause;
+  resultClause.addLits(~outputs[k]);
+  result.addClauses(resultClause);
+  return result;
+}
+
+/**
+ * @brief      Builds a totalizer that counts the True literals in a range of
+ * the given literals, in unary.
+ *
+ * The output i is implied to be True if at least i + 1 of the literals are
+ * True. Only the outputs up to the given limit are created, as larger counts
+ * need not be told apart. Only the clauses that imply the outputs are
+ * added, which is enough for limiting the count from above.
+ *
+ * @param[in]  lits    The literals
+ * @param[in]  begin   The index of the first literal of the range
+ * @param[in]  end     The index after the last literal of the range
+ * @param[in]  limit   The maximum number of outputs
+ * @param      result  The Clauses to which the clauses are added
+ *
+ * @return     The outputs of the totalizer
+ */
+std::vector<Lit> EncodingContext::totalizer(const std::vector<Lit> &lits,
+                                              unsigned begin, unsigned end,
+                                              unsigned limit,
+                                              Clauses &result) {
+  if (end - begin == 1) {
+    return std::vector<Lit>(1, lits[begin]);
+  }
+  unsigned middle = begin + (end - begin) / 2;
+  std::vector<Lit> left = totalizer(lits, begin, middle, limit, result);
+  std::vector<Lit> right = totalizer(lits, middle, end, limit, result);
+  std::vector<Lit> outputs;
+  unsigned outputCount = std::min<unsigned>(end - begin, limit);
+  for (unsigned i = 0; i < outputCount; i++) {
+    outputs.push_back(newLiteral());
+  }
+  for (unsigned i = 0; i <= left.size(); i++) {
+    for (unsigned j = 0; j <= right.size(); j++) {
+      if (i + j == 0 || i + j > outputCount) {
+        continue;
+      }
+      CClause resultClause;
+      if (i > 0) {
+        resultClause.addLits(~left[i - 1]);
+      }
+      if (j > 0) {
+        resultClause.addLits(~right[j - 1]);
+      }
+      resultClause.addLits(outputs[i + j - 1]);
+      result.addClauses(resultClause);
+    }
+  }
+  return outputs;
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most one of the given
+ * literals is True, using the binomial encoding.
+ *
+ * @param[in]  lits  The literals
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses EncodingContext::atMostOneBinomial(const std::vector<Lit> &lits) {
+  Clauses result(this);
+  for (unsigned i = 0; i < lits.size(); i++) {
+    for (unsigned j = i + 1; j < lits.size(); j++) {
+      Clauses first(lits[i], this);
+      Clauses second(lits[j], this);
+      Clauses negSecond = ~second;
+      result.addClauses(~first | negSecond);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most one of the given
+ * literals is True, using the sequential counter encoding.
+ *
+ * The counter variable s_i is True if any of the first i + 1 literals is True.
+ * This needs 3n - 4 clauses for n literals, so the binomial encoding is used
+ * for up to 5 literals, where it does not need more clauses. As this uses
+ * auxiliary variables, these clauses must not be negated.
+ *
+ * @param[in]  lits  The literals
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses EncodingContext::atMostOneSequential(const std::vector<Lit> &lits) {
+  if (lits.size() <= 5) {
+    return atMostOneBinomial(lits);
+  }
+  Clauses result(this);
+  Lit previousCounter = lit_Undef;
+  for (unsigned i = 0; i < lits.size(); i++) {
+    if (i > 0) {
+      // no earlier literal may have been counted already
+      CClause resultClause;
+      resultClause.addLits(~lits[i], ~previousCounter);
+      result.addClauses(resultClause);
+    }
+    if (i + 1 < lits.size()) {
+      Lit counter = newLiteral();
+      CClause resultClause;
+      resultClause.addLits(~lits[i], counter);
+      result.addClauses(resultClause);
+      if (i > 0) {
+        CClause propagateClause;
+        propagateClause.addLits(~previousCounter, counter);
+        result.addClauses(propagateClause);
+      }
+      previousCounter = counter;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Gives Clauses that represent that at most one of the given
+ * literals is True, using the product encoding.
+ *
+ * The literals are arranged in a grid with p rows and q columns, where p is
+ * about the square root of their number, and each literal implies the
+ * variables of its row and its column. Two True literals would then make two
+ * rows or two columns True, so at most one row and at most one column are
+ * allowed to be True, which is encoded recursively. This needs about
+ * 2n + 4 sqrt(n) clauses for n literals, so the binomial encoding is used for
+ * up to 5 literals. As this uses auxiliary variables, these clauses must not
+ * be negated.
+ *
+ * @param[in]  lits  The literals
+ *
+ * @return     A Clauses object representing the condition
+ */
+Clauses EncodingContext::atMostOneProduct(const std::vector<Lit> &lits) {
+  if (lits.size() <= 5) {
+    return atMostOneBinomial(lits);
+  }
+  unsigned rowCount = 1;
+  while (rowCount * rowCount < lits.size()) {
+    rowCount++;
+  }
+  unsigned columnCount = (lits.size() + rowCount - 1) / rowCount;
+  std::vector<Lit> rows, columns;
+  for (unsigned i = 0; i < rowCount; i++) {
+    rows.push_back(newLiteral());
+  }
+  for (unsigned i = 0; i < columnCount; i++) {
+    columns.push_back(newLiteral());
+  }
+  Clauses result(this);
+  for (unsigned i = 0; i < lits.size(); i++) {
+    CClause rowClause, columnClause;
+    rowClause.addLits(~lits[i], rows[i / columnCount]);
+    columnClause.addLits(~lits[i], columns[i % columnCount]);
+    result.addClauses(rowClause);
+    result.addClauses(columnClause);
+  }
+  result.addClauses(atMostOneProduct(rows));
+  result.addClauses(atMostOneProduct(columns));
+  return result;
+}
+
+/**
+ * @brief      Gets the total weight of the soft clauses added so far.
+ *
+ * @return     The total weight
+ */
+uint64_t EncodingContext::getSoftWeight() const { return softWeight; }
+
+/**
+ * @brief      Hashes a vector of literals.
+ *
+ * @param[in]  lits  The literals
+ *
+ * @return     The hash
+ */
+std::size_t LitVectorHash::operator()(const std::vector<Lit> &lits) const {
+  std::size_t hash = lits.size();
+  for (const Lit &lit : lits) {
+    hash ^= std::hash<int>()(toInt(lit)) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+  }
+  return hash;
+}
+
+/**
+ * @brief      Destroys the EncodingContext object, along with its ClauseSink.
+ */
+EncodingContext::~EncodingContext() { delete sink; }
@@ -0,0 +1,98 @@
+#include "field_value_index.h"
+
+#include <cstdint>
+#include <vector>
+#include "core/SolverTypes.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the FieldValueIndex object, with no field values and
+ * no courses.
+ */
+FieldValueIndex::FieldValueIndex() {
+  init(std::vector<unsigned>(Global::FIELD_COUNT, 0));
+}
+
+/**
+ * @brief      Sets the number of field values of each FieldType, and removes
+ * all courses.
+ *
+ * @param[in]  counts  The number of field values of each FieldType
+ */
+void FieldValueIndex::init(const std::vector<unsigned> &counts) {
+  valueCounts = counts;
+  fieldOffsets.assign(Global::FIELD_COUNT, 0);
+  stride = 0;
+  for (unsigned i = 0; i < Global::FIELD_COUNT; i++) {
+    fieldOffsets[i] = stride;
+    stride += valueCounts[i];
+  }
+  courseCount = 0;
+  vars.clear();
+  existingAssignments.clear();
+}
+
+/**
+ * @brief      Adds a Course, whose field values have no variables and no
+ * existing assignments.
+ *
+ * @return     The index of the Course
+ */
+int FieldValueIndex::addCourse() {
+  courseCount++;
+  vars.resize(courseCount * stride, var_Undef);
+  existingAssignments.resize((courseCount * stride + 31) / 32, 0);
+  return courseCount - 1;
+}
+
+/**
+ * @brief      Gets the number of courses.
+ *
+ * @return     The number of courses
+ */
+unsigned FieldValueIndex::getCourseCount() const { return courseCount; }
+
+/**
+ * @brief      Gets the number of field values of a FieldType, which is the
+ * same for every Course.
+ *
+ * @param[in]  fieldType  The field type
+ *
+ * @return     The number of field values
+ */
+unsigned FieldValueIndex::getValueCount(FieldType fieldType) const {
+  return valueCounts[fieldType];
+}
+
+/**
+ * @brief      Sets the variable of a field value of a Course.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ * @param[in]  var        The variable
+ */
+void FieldValueIndex::setVar(int course, FieldType fieldType, int value,
+                             Var var) {
+  vars[position(course, fieldType, value)] = var;
+}
+
+/**
+ * @brief      Sets the existing assignment of a field value of a Course.
+ *
+ * @param[in]  course      The course
+ * @param[in]  fieldType   The field type
+ * @param[in]  value       The index of the field value
+ * @param[in]  assignment  The existing assignment
+ */
+void FieldValueIndex::setExistingAssignment(int course, FieldType fieldType,
+                                            int value, lbool assignment) {
+  unsigned entry = position(course, fieldType, value);
+  uint64_t bits =
+      (assignment == l_Undef) ? 0 : ((assignment == l_True) ? 1 : 2);
+  unsigned shift = 2 * (entry % 32);
+  existingAssignments[entry / 32] &= ~(uint64_t(3) << shift);
+  existingAssignments[entry / 32] |= bits << shift;
+}
@@ -39,6 +39,22 @@ bool Segment::operator==(const Segment &other) {
  */
 int Segment::length() { return (endSegment - startSegment + 1); }
 
+/**
+ * @brief      Gets the start segment ID of the Segment.
+ *             For example, the start segment of 16 is 1.
+ *
+ * @return     The start segment ID
+ */
+int Segment::getStartSegment() { return startSegment; }
+
+/**
+ * @brief      Gets the end segment ID of the Segment.
+ *             For example, the end segment of 16 is 6.
+ *
+ * @return     The end segment ID
+ */
+int Segment::getEndSegment() { return endSegment; }
+
 /**
  * @brief      Determines if two Segments are intersecting.
  *             Two segments are said to be intersecting if they contain a common
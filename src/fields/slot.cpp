@@ -112,6 +112,15 @@ std::string Time::getTimeString() {
   return std::to_string(hours) + ":" + std::to_string(minutes);
 }
 
+/**
+ * @brief      Gets the number of minutes elapsed since midnight.
+ *
+ *             For example, 10 hours and 30 minutes is represented as 630.
+ *
+ * @return     The minutes since midnight.
+ */
+unsigned Time::getMinutesFromMidnight() { return hours * 60 + minutes; }
+
 /**
  * @brief      Determines if the Time is a morning time.
  *
@@ -170,6 +179,27 @@ bool SlotElement::isIntersecting(SlotElement &other) {
  */
 bool SlotElement::isMorningSlotElement() { return startTime.isMorningTime(); }
 
+/**
+ * @brief      Gets the Day of the SlotElement.
+ *
+ * @return     The Day.
+ */
+Day SlotElement::getDay() { return day; }
+
+/**
+ * @brief      Gets the start Time of the SlotElement.
+ *
+ * @return     The start Time.
+ */
+Time SlotElement::getStartTime() { return startTime; }
+
+/**
+ * @brief      Gets the end Time of the SlotElement.
+ *
+ * @return     The end Time.
+ */
+Time SlotElement::getEndTime() { return endTime; }
+
 /**
  * @brief      Constructs the Slot object.
  *
@@ -224,6 +254,13 @@ void Slot::addSlotElements(SlotElement slotElement) {
   slotElements.push_back(slotElement);
 }
 
+/**
+ * @brief      Gets the slot elements that define the Slot.
+ *
+ * @return     The slot elements.
+ */
+std::vector<SlotElement> Slot::getSlotElements() { return slotElements; }
+
 /**
  * @brief      Gets the type under the FieldType enum.
  *
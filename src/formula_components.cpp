@@ -0,0 +1,142 @@
+#include "formula_components.h"
+
+#include <vector>
+#include "clause_sink.h"
+#include "core/SolverTypes.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the FormulaComponents object, and finds the
+ * components of the clauses in a buffer.
+ *
+ * Variables that are in no clause are in no component.
+ *
+ * @param[in]  buffer    The clauses
+ * @param[in]  varCount  The number of variables
+ * @param[in]  split     False to keep all clauses except empty ones in a
+ * single component
+ */
+FormulaComponents::FormulaComponents(const BufferClauseSink &buffer,
+                                     int varCount, bool split) {
+  parents.resize(varCount);
+  for (Var v = 0; v < varCount; v++) {
+    parents[v] = v;
+  }
+  Var root = var_Undef;
+  for (unsigned i = 0; i < buffer.size(); i++) {
+    const Lit *lits = buffer.getClause(i);
+    for (unsigned j = 1; j < buffer.getClauseSize(i); j++) {
+      Var first = find(var(lits[0]));
+      Var other = find(var(lits[j]));
+      if (first != other) {
+        parents[other] = first;
+      }
+    }
+    if (!split && buffer.getClauseSize(i) > 0) {
+      if (root == var_Undef) {
+        root = var(lits[0]);
+      }
+      Var first = find(root);
+      Var other = find(var(lits[0]));
+      if (first != other) {
+        parents[other] = first;
+      }
+    }
+  }
+  std::vector<int> setSizes(varCount, 0);
+  for (Var v = 0; v < varCount; v++) {
+    setSizes[find(v)]++;
+  }
+  // number the components in the order of their first clauses
+  std::vector<int> componentIndex(varCount, -1);
+  int smallIndex = -1;
+  for (unsigned i = 0; i < buffer.size(); i++) {
+    if (buffer.getClauseSize(i) == 0) {
+      // an empty clause belongs to no variable, but must still be solved
+      clauses.push_back(std::vector<unsigned>(1, i));
+      vars.push_back(std::vector<Var>());
+      continue;
+    }
+    Var root = find(var(buffer.getClause(i)[0]));
+    if (componentIndex[root] == -1) {
+      bool isSmall = setSizes[root] < MIN_VAR_COUNT;
+      if (!isSmall || smallIndex == -1) {
+        componentIndex[root] = clauses.size();
+        clauses.push_back(std::vector<unsigned>());
+        vars.push_back(std::vector<Var>());
+        if (isSmall) {
+          smallIndex = componentIndex[root];
+        }
+      } else {
+        componentIndex[root] = smallIndex;
+      }
+    }
+    clauses[componentIndex[root]].push_back(i);
+  }
+  localVars.assign(varCount, var_Undef);
+  for (Var v = 0; v < varCount; v++) {
+    int component = componentIndex[find(v)];
+    if (component != -1) {
+      localVars[v] = vars[component].size();
+      vars[component].push_back(v);
+    }
+  }
+}
+
+/**
+ * @brief      Finds the representative of the set of a variable, and
+ * shortens the path to it.
+ *
+ * @param[in]  v     The variable
+ *
+ * @return     The representative variable
+ */
+Var FormulaComponents::find(Var v) {
+  while (parents[v] != v) {
+    parents[v] = parents[parents[v]];
+    v = parents[v];
+  }
+  return v;
+}
+
+/**
+ * @brief      Gets the number of components.
+ *
+ * @return     The number of components
+ */
+unsigned FormulaComponents::size() const { return clauses.size(); }
+
+/**
+ * @brief      Gets the clauses of a component.
+ *
+ * @param[in]  component  The index of the component
+ *
+ * @return     The indices of the clauses in the buffer
+ */
+const std::vector<unsigned> &FormulaComponents::getClauses(
+    unsigned component) const {
+  return clauses[component];
+}
+
+/**
+ * @brief      Gets the variables of a component.
+ *
+ * @param[in]  component  The index of the component
+ *
+ * @return     The variables, in increasing order
+ */
+const std::vector<Var> &FormulaComponents::getVars(unsigned component) const {
+  return vars[component];
+}
+
+/**
+ * @brief      Gets the index of a variable among the variables of its
+ * component, which is its variable in the formula of the component.
+ *
+ * @param[in]  v     The variable
+ *
+ * @return     The local variable, or var_Undef if the variable is in no
+ * component
+ */
+Var FormulaComponents::getLocalVar(Var v) const { return localVars[v]; }
@@ -1,15 +1,19 @@
 #include <getopt.h>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include "clause_sink.h"
 #include "constraint_adder.h"
 #include "constraint_encoder.h"
 #include "core/Solver.h"
 #include "custom_parser.h"
 #include "global.h"
-#include "global_vars.h"
 #include "mtl/Vec.h"
 #include "parser.h"
+#include "timetabler.h"
 #include "utils.h"
 #include "version.h"
 
@@ -37,6 +41,27 @@ const struct option long_options[] = {{"help", no_argument, 0, 'h'},
                                       {"custom", required_argument, 0, 'c'},
                                       {"output", required_argument, 0, 'o'},
                                       {"verbosity", required_argument, 0, 'b'},
+                                      {"time-encoding", required_argument, 0,
+                                       'e'},
+                                      {"wcnf", required_argument, 0, 'w'},
+                                      {"threads", required_argument, 0, 't'},
+                                      {"amo-encoding", required_argument, 0,
+                                       'a'},
+                                      {"segment-encoding", required_argument,
+                                       0, 's'},
+                                      {"symmetry-breaking", required_argument,
+                                       0, 'y'},
+                                      {"selectors", required_argument, 0, 'x'},
+                                      {"decompose", required_argument, 0, 'd'},
+                                      {"match-classrooms", required_argument,
+                                       0, 'm'},
+                                      {"time-limit", required_argument, 0,
+                                       'l'},
+                                      {"portfolio", required_argument, 0, 'p'},
+                                      {"warm-start", required_argument, 0,
+                                       'r'},
+                                      {"progress-fd", required_argument, 0,
+                                       'g'},
                                       {"version", no_argument, 0, 'v'},
                                       {0, 0, 0, 0}};
 
@@ -48,7 +73,34 @@ const std::string option_desc[] = {"display this help",
                                    "input csv file",
                                    "custom constraints file",
                                    "output csv file",
-                                   "specify verbosity level (0-3)"
+                                   "specify verbosity level (0-3)",
+                                   "time encoding (pairwise or occupancy)",
+                                   "write the formula to a wcnf file instead "
+                                   "of solving",
+                                   "number of threads for generating "
+                                   "constraints and solving components",
+                                   "at most one encoding (binomial, "
+                                   "sequential or product)",
+                                   "segment encoding (interval or order)",
+                                   "break symmetries between interchangeable "
+                                   "classrooms and slots (on or off)",
+                                   "selector variables for hard constraints "
+                                   "(auto: only to explain a failure, or "
+                                   "always)",
+                                   "solve the independent components of the "
+                                   "formula separately (on or off, on by "
+                                   "default with more than one thread)",
+                                   "assign classrooms by matching after "
+                                   "solving for the other fields (on or off)",
+                                   "stop solving after the given number of "
+                                   "seconds, keeping the best timetable",
+                                   "comma separated solvers to run in "
+                                   "parallel on each component (stratified, "
+                                   "unstratified or randomized)",
+                                   "csv file with a previous timetable that "
+                                   "the solver tries first",
+                                   "file descriptor to write the progress "
+                                   "of the solvers to as json lines",
                                    "display version",
                                    ""};
 
@@ -64,7 +116,7 @@ void display_help(std::string exec = "timetabler") {
             << " -i|--input <input_file>"
                " -f|--fields <fields_file>"
                " [-c|--custom <custom_constraints_file>]"
-               " -o|--output <output_file>"
+               " -o|--output <output_file>|-w|--wcnf <wcnf_file>"
                "\n\n";
   std::cout << "Options:\n";
   for (int i = 0; long_options[i].name != 0; i++) {
@@ -87,8 +139,6 @@ void display_error(std::string err) {
   exit(1);
 }
 
-Timetabler *timetabler;
-
 /**
  * @brief      The main function
  *
@@ -98,13 +148,27 @@ Timetabler *timetabler;
  * @return     Exit code when program ends
  */
 int main(int argc, char *const *argv) {
-  std::string input_file, fields_file, custom_file, output_file;
+  std::string input_file, fields_file, custom_file, output_file, wcnf_file,
+      warm_start_file;
   unsigned verbosity = 3;
+  TimeEncoding timeEncoding = TimeEncoding::pairwise;
+  int threadCount = 1;
+  AMOEncoding amoEncoding = AMOEncoding::sequential;
+  SegmentEncoding segmentEncoding = SegmentEncoding::interval;
+  bool symmetryBreaking = true;
+  bool alwaysSelectors = false;
+  bool decompose = false;
+  bool decomposeGiven = false;
+  bool matchClassrooms = false;
+  double timeLimit = 0;
+  int progressFd = -1;
+  std::vector<SolverConfiguration> portfolio(1,
+                                             SolverConfiguration::stratified);
 
   while (1) {
     int option_index = 0;
-    int c =
-        getopt_long(argc, argv, "hi:f:c:o:b:v", long_options, &option_index);
+    int c = getopt_long(argc, argv, "hi:f:c:o:b:e:w:t:a:s:y:x:d:m:l:p:r:g:v",
+                        long_options, &option_index);
 
     if (c == -1) break;
 
@@ -132,6 +196,122 @@ int main(int argc, char *const *argv) {
       case 'b':
         verbosity = std::stoi(optarg);
         break;
+      case 'w':
+        wcnf_file = std::string(optarg);
+        break;
+      case 'r':
+        warm_start_file = std::string(optarg);
+        break;
+      case 'g':
+        progressFd = std::stoi(optarg);
+        if (progressFd < 0) {
+          display_error("File descriptor must not be negative");
+        }
+        break;
+      case 't':
+        threadCount = std::stoi(optarg);
+        if (threadCount < 1) {
+          display_error("Number of threads must be at least 1");
+        }
+        break;
+      case 'a':
+        if (std::string(optarg) == "binomial") {
+          amoEncoding = AMOEncoding::binomial;
+        } else if (std::string(optarg) == "sequential") {
+          amoEncoding = AMOEncoding::sequential;
+        } else if (std::string(optarg) == "product") {
+          amoEncoding = AMOEncoding::product;
+        } else {
+          display_error("Unrecognised at most one encoding: " +
+                        std::string(optarg));
+        }
+        break;
+      case 's':
+        if (std::string(optarg) == "interval") {
+          segmentEncoding = SegmentEncoding::interval;
+        } else if (std::string(optarg) == "order") {
+          segmentEncoding = SegmentEncoding::order;
+        } else {
+          display_error("Unrecognised segment encoding: " +
+                        std::string(optarg));
+        }
+        break;
+      case 'y':
+        if (std::string(optarg) == "on") {
+          symmetryBreaking = true;
+        } else if (std::string(optarg) == "off") {
+          symmetryBreaking = false;
+        } else {
+          display_error("Unrecognised symmetry breaking switch: " +
+                        std::string(optarg));
+        }
+        break;
+      case 'x':
+        if (std::string(optarg) == "auto") {
+          alwaysSelectors = false;
+        } else if (std::string(optarg) == "always") {
+          alwaysSelectors = true;
+        } else {
+          display_error("Unrecognised selectors mode: " +
+                        std::string(optarg));
+        }
+        break;
+      case 'd':
+        decomposeGiven = true;
+        if (std::string(optarg) == "on") {
+          decompose = true;
+        } else if (std::string(optarg) == "off") {
+          decompose = false;
+        } else {
+          display_error("Unrecognised decomposition switch: " +
+                        std::string(optarg));
+        }
+        break;
+      case 'm':
+        if (std::string(optarg) == "on") {
+          matchClassrooms = true;
+        } else if (std::string(optarg) == "off") {
+          matchClassrooms = false;
+        } else {
+          display_error("Unrecognised classroom matching switch: " +
+                        std::string(optarg));
+        }
+        break;
+      case 'l':
+        timeLimit = std::stod(optarg);
+        if (timeLimit <= 0) {
+          display_error("Time limit must be positive");
+        }
+        break;
+      case 'p': {
+        portfolio.clear();
+        std::stringstream configurations(optarg);
+        std::string configuration;
+        while (std::getline(configurations, configuration, ',')) {
+          if (configuration == "stratified") {
+            portfolio.push_back(SolverConfiguration::stratified);
+          } else if (configuration == "unstratified") {
+            portfolio.push_back(SolverConfiguration::unstratified);
+          } else if (configuration == "randomized") {
+            portfolio.push_back(SolverConfiguration::randomized);
+          } else {
+            display_error("Unrecognised solver: " + configuration);
+          }
+        }
+        if (portfolio.empty()) {
+          display_error("The portfolio must have at least one solver");
+        }
+        break;
+      }
+      case 'e':
+        if (std::string(optarg) == "pairwise") {
+          timeEncoding = TimeEncoding::pairwise;
+        } else if (std::string(optarg) == "occupancy") {
+          timeEncoding = TimeEncoding::occupancy;
+        } else {
+          display_error("Unrecognised time encoding: " + std::string(optarg));
+        }
+        break;
       case '?':
         break;
       default:
@@ -145,31 +325,113 @@ int main(int argc, char *const *argv) {
     display_error("Unrecognised argument: " + std::string(argv[optind]));
   }
 
-  if (input_file == "" || fields_file == "" || output_file == "") {
+  if (input_file == "" || fields_file == "" ||
+      (output_file == "" && wcnf_file == "")) {
     display_error(
-        "Fields filename, input filename and output filename are required.");
+        "Fields filename, input filename, and either an output filename or a "
+        "wcnf filename are required.");
+  }
+
+  // buffering the clauses for the components only pays off when they can be
+  // solved in parallel
+  if (!decomposeGiven) {
+    decompose = threadCount > 1;
   }
 
-  timetabler = new Timetabler();
-  Parser parser(timetabler);
-  parser.parseFields(fields_file);
-  parser.parseInput(input_file);
-  if (parser.verify()) {
-    LOG(INFO) << "Input is valid";
-  } else {
-    LOG(ERROR) << "Input is invalid";
+  // the time limit covers encoding and every solve
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+  if (timeLimit > 0) {
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(timeLimit));
+  }
+
+  /*
+   * Encodes the problem in a new Timetabler. Without selector variables for
+   * the hard constraints, the formula is much smaller, but the constraints
+   * that could not be satisfied cannot be found. To find them, the selector
+   * variables of the hard constraints can be made soft instead. The
+   * Classrooms can be left to be assigned by matching after solving.
+   */
+  auto encode = [&](bool directHardConstraints, bool relaxHardConstraints,
+                    bool matchClassrooms) {
+    Timetabler *timetabler = new Timetabler();
+    timetabler->data.timeEncoding = timeEncoding;
+    timetabler->data.threadCount = threadCount;
+    timetabler->data.amoEncoding = amoEncoding;
+    timetabler->data.segmentEncoding = segmentEncoding;
+    timetabler->data.symmetryBreaking = symmetryBreaking;
+    timetabler->data.directHardConstraints = directHardConstraints;
+    timetabler->data.relaxHardConstraints = relaxHardConstraints;
+    timetabler->data.matchClassrooms = matchClassrooms;
+    timetabler->data.deadline = deadline;
+    timetabler->data.portfolio = portfolio;
+    timetabler->data.progressFd = progressFd;
+    if (wcnf_file != "") {
+      timetabler->setClauseSink(new WCNFClauseSink(wcnf_file));
+    } else if (decompose || portfolio.size() > 1) {
+      timetabler->bufferClauses(decompose);
+    }
+    Parser parser(timetabler);
+    parser.parseFields(fields_file);
+    parser.parseInput(input_file);
+    if (parser.verify()) {
+      LOG(INFO) << "Input is valid";
+    } else {
+      LOG(ERROR) << "Input is invalid";
+    }
+    parser.reduceDomains();
+    parser.addVars();
+    if (warm_start_file != "") {
+      parser.parseWarmStart(warm_start_file);
+    }
+    ConstraintEncoder encoder(timetabler);
+    ConstraintAdder constraintAdder(&encoder, timetabler);
+    constraintAdder.addConstraints();
+    if (custom_file != "") {
+      parseCustomConstraints(custom_file, &encoder, timetabler);
+      LOG(INFO) << "Custom constraints parsed.";
+    }
+    constraintAdder.addSymmetryBreaking();
+    timetabler->addHighLevelClauses();
+    timetabler->addExistingAssignments();
+    timetabler->addRelaxedHardClauses();
+    return timetabler;
+  };
+
+  Timetabler *timetabler =
+      encode(!alwaysSelectors, false, matchClassrooms && wcnf_file == "");
+  if (timetabler->matchesClassrooms() &&
+      timetabler->data.customClassroomConstraints) {
+    LOG(WARNING) << "Custom constraints on classrooms cannot be matched, "
+                    "encoding the classroom constraints instead";
+    delete timetabler;
+    timetabler = encode(!alwaysSelectors, false, false);
   }
-  parser.addVars();
-  ConstraintEncoder encoder(timetabler);
-  ConstraintAdder constraintAdder(&encoder, timetabler);
-  constraintAdder.addConstraints();
-  if (custom_file != "") {
-    parseCustomConstraints(custom_file, &encoder, timetabler);
-    LOG(INFO) << "Custom constraints parsed.";
+  if (wcnf_file != "") {
+    LOG(INFO) << "Formula written to " << wcnf_file;
+    delete timetabler;
+    return 0;
   }
-  timetabler->addHighLevelClauses();
-  timetabler->addExistingAssignments();
   SolverStatus solverStatus = timetabler->solve();
+  if (!timetabler->assignClassrooms()) {
+    LOG(WARNING) << "Solving again with the classroom constraints";
+    delete timetabler;
+    timetabler = encode(!alwaysSelectors, false, false);
+    solverStatus = timetabler->solve();
+  }
+  if (solverStatus == SolverStatus::Unsolved && !alwaysSelectors) {
+    LOG(WARNING) << "Hard constraints could not be satisfied, solving again "
+                    "with selector variables to explain the failure";
+    delete timetabler;
+    timetabler = encode(false, true, false);
+    solverStatus = timetabler->solve();
+    timetabler->printResult(solverStatus);
+    // the timetable breaks the hard constraints that are reported
+    delete timetabler;
+    return 0;
+  }
   timetabler->printResult(solverStatus);
   if (solverStatus == SolverStatus::Solved ||
       solverStatus == SolverStatus::HighLevelFailed) {
@@ -1,7 +1,10 @@
 #include "parser.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 #include "utils.h"
 
 /**
@@ -40,6 +43,10 @@ void Parser::parseFields(std::string file) {
       timetabler->data.segments.push_back(Segment(i, j));
     }
   }
+  if (segmentsConfig["keep_length"]) {
+    timetabler->data.keepSegmentLength =
+        segmentsConfig["keep_length"].as<bool>();
+  }
 
   YAML::Node slotsConfig = config["slots"];
   for (YAML::Node slotNode : slotsConfig) {
@@ -97,6 +104,115 @@ void Parser::parseFields(std::string file) {
     int weight = predefinedWeightNode["weight"].as<int>();
     timetabler->data.predefinedClausesWeights[clauseNo] = weight;
   }
+
+  computeTimeAtoms();
+  computeIntersections();
+}
+
+/**
+ * @brief      Computes whether each pair of Slots and each pair of Segments
+ * is intersecting, and stores the results in the data.
+ *
+ * This is done once after parsing the fields, so that the encoders do not
+ * have to repeat the comparisons for every pair of courses.
+ */
+void Parser::computeIntersections() {
+  std::vector<Slot> &slots = timetabler->data.slots;
+  timetabler->data.slotIntersections.assign(
+      slots.size(), std::vector<bool>(slots.size(), false));
+  for (unsigned i = 0; i < slots.size(); i++) {
+    for (unsigned j = i; j < slots.size(); j++) {
+      bool intersecting = slots[i].isIntersecting(slots[j]);
+      timetabler->data.slotIntersections[i][j] = intersecting;
+      timetabler->data.slotIntersections[j][i] = intersecting;
+    }
+  }
+  std::vector<Segment> &segments = timetabler->data.segments;
+  timetabler->data.segmentIntersections.assign(
+      segments.size(), std::vector<bool>(segments.size(), false));
+  for (unsigned i = 0; i < segments.size(); i++) {
+    for (unsigned j = i; j < segments.size(); j++) {
+      bool intersecting = segments[i].isIntersecting(segments[j]);
+      timetabler->data.segmentIntersections[i][j] = intersecting;
+      timetabler->data.segmentIntersections[j][i] = intersecting;
+    }
+  }
+}
+
+/**
+ * @brief      Splits the week into time periods and the segments into segment
+ * units, and stores which of them each Slot and Segment covers.
+ *
+ * For every Day, the start and end Times of all SlotElements on that Day are
+ * taken as boundaries, and every interval between two consecutive boundaries
+ * that some SlotElement covers is a time period. Two Slots intersect exactly
+ * when they cover a common time period, and two Segments intersect exactly
+ * when they cover a common segment unit.
+ */
+void Parser::computeTimeAtoms() {
+  const unsigned dayCount = 7;
+  std::vector<std::vector<unsigned>> boundaries(dayCount);
+  for (Slot slot : timetabler->data.slots) {
+    for (SlotElement element : slot.getSlotElements()) {
+      unsigned day = static_cast<unsigned>(element.getDay());
+      boundaries[day].push_back(
+          element.getStartTime().getMinutesFromMidnight());
+      boundaries[day].push_back(element.getEndTime().getMinutesFromMidnight());
+    }
+  }
+  // periodStart[day][k] is the index of the period starting at
+  // boundaries[day][k], or -1 if no SlotElement covers that interval
+  std::vector<std::vector<int>> periodStart(dayCount);
+  unsigned periodCount = 0;
+  for (unsigned day = 0; day < dayCount; day++) {
+    std::sort(boundaries[day].begin(), boundaries[day].end());
+    boundaries[day].erase(
+        std::unique(boundaries[day].begin(), boundaries[day].end()),
+        boundaries[day].end());
+    periodStart[day].resize(boundaries[day].size(), -1);
+  }
+  timetabler->data.slotPeriods.clear();
+  for (Slot slot : timetabler->data.slots) {
+    std::vector<unsigned> periods;
+    for (SlotElement element : slot.getSlotElements()) {
+      unsigned day = static_cast<unsigned>(element.getDay());
+      unsigned start = element.getStartTime().getMinutesFromMidnight();
+      unsigned end = element.getEndTime().getMinutesFromMidnight();
+      for (unsigned k = 0; k + 1 < boundaries[day].size(); k++) {
+        if (boundaries[day][k] >= start && boundaries[day][k + 1] <= end) {
+          if (periodStart[day][k] == -1) {
+            periodStart[day][k] = periodCount++;
+          }
+          periods.push_back(periodStart[day][k]);
+        }
+      }
+    }
+    std::sort(periods.begin(), periods.end());
+    periods.erase(std::unique(periods.begin(), periods.end()), periods.end());
+    timetabler->data.slotPeriods.push_back(periods);
+  }
+  timetabler->data.periodCount = periodCount;
+
+  int firstUnit = 0, lastUnit = -1;
+  for (unsigned i = 0; i < timetabler->data.segments.size(); i++) {
+    Segment &segment = timetabler->data.segments[i];
+    if (i == 0 || segment.getStartSegment() < firstUnit) {
+      firstUnit = segment.getStartSegment();
+    }
+    if (i == 0 || segment.getEndSegment() > lastUnit) {
+      lastUnit = segment.getEndSegment();
+    }
+  }
+  timetabler->data.segmentUnitCount = lastUnit - firstUnit + 1;
+  timetabler->data.segmentUnits.clear();
+  for (Segment segment : timetabler->data.segments) {
+    std::vector<unsigned> units;
+    for (int unit = segment.getStartSegment(); unit <= segment.getEndSegment();
+         unit++) {
+      units.push_back(unit - firstUnit);
+    }
+    timetabler->data.segmentUnits.push_back(units);
+  }
 }
 
 /**
@@ -128,9 +244,18 @@ Day Parser::getDayFromString(std::string day) {
  */
 void Parser::parseInput(std::string file) {
   csv::Parser parser(file);
-  timetabler->data.existingAssignmentVars.clear();
+  Data &data = timetabler->data;
+  std::vector<unsigned> valueCounts(Global::FIELD_COUNT);
+  valueCounts[FieldType::classroom] = data.classrooms.size();
+  valueCounts[FieldType::instructor] = data.instructors.size();
+  valueCounts[FieldType::isMinor] = data.isMinors.size();
+  valueCounts[FieldType::program] = data.programs.size();
+  valueCounts[FieldType::segment] = data.segments.size();
+  valueCounts[FieldType::slot] = data.slots.size();
+  FieldValueIndex &index = data.fieldValueIndex;
+  index.init(valueCounts);
   for (unsigned i = 0; i < parser.rowCount(); ++i) {
-    std::vector<std::vector<lbool>> assignmentsThisCourse(Global::FIELD_COUNT);
+    int c = index.addCourse();
 
     std::string name = parser[i]["name"];
     std::string classSizeStr = parser[i]["class_size"];
@@ -138,103 +263,207 @@ void Parser::parseInput(std::string file) {
 
     std::string instructorStr = parser[i]["instructor"];
     int instructor = -1;
-    for (unsigned j = 0; j < timetabler->data.instructors.size(); j++) {
-      if (timetabler->data.instructors[j].getName() == instructorStr) {
+    for (unsigned j = 0; j < data.instructors.size(); j++) {
+      if (data.instructors[j].getName() == instructorStr) {
         instructor = j;
-        assignmentsThisCourse[FieldType::instructor].push_back(l_True);
+        index.setExistingAssignment(c, FieldType::instructor, j, l_True);
         continue;
       }
-      assignmentsThisCourse[FieldType::instructor].push_back(l_False);
+      index.setExistingAssignment(c, FieldType::instructor, j, l_False);
     }
     if (instructor == -1) {
       LOG(ERROR) << "Input contains invalid Instructor name";
     }
     std::string segmentStr = parser[i]["segment"];
     int segment = -1;
-    for (unsigned j = 0; j < timetabler->data.segments.size(); j++) {
-      if (timetabler->data.segments[j].getName() == segmentStr) {
+    for (unsigned j = 0; j < data.segments.size(); j++) {
+      if (data.segments[j].getName() == segmentStr) {
         segment = j;
-        assignmentsThisCourse[FieldType::segment].push_back(l_True);
+        index.setExistingAssignment(c, FieldType::segment, j, l_True);
         continue;
       }
-      assignmentsThisCourse[FieldType::segment].push_back(l_False);
+      index.setExistingAssignment(c, FieldType::segment, j, l_False);
     }
     if (segment == -1) {
       LOG(ERROR) << "Input contains invalid Segment name";
     }
     std::string isMinorStr = parser[i]["is_minor"];
     MinorType isMinor = MinorType::isMinorCourse;
+    const int isMinorValue = static_cast<int>(MinorType::isMinorCourse);
     if (isMinorStr == "Yes" || isMinorStr == "Y") {
       isMinor = MinorType::isMinorCourse;
-      assignmentsThisCourse[FieldType::isMinor].push_back(l_True);
+      index.setExistingAssignment(c, FieldType::isMinor, isMinorValue, l_True);
     } else if (isMinorStr == "No" || isMinorStr == "N" || isMinorStr == "") {
       isMinor = MinorType::isNotMinorCourse;
-      assignmentsThisCourse[FieldType::isMinor].push_back(l_False);
+      index.setExistingAssignment(c, FieldType::isMinor, isMinorValue,
+                                  l_False);
     } else {
       LOG(ERROR) << "Input contains invalid IsMinor value (should be "
                     "'Yes' or 'No')";
     }
     Course course(name, classSize, instructor, segment, isMinor);
 
-    for (unsigned j = 0; j < timetabler->data.programs.size(); j += 2) {
-      std::string s = timetabler->data.programs[j].getName();
+    for (unsigned j = 0; j < data.programs.size(); j += 2) {
+      std::string s = data.programs[j].getName();
+      lbool core = l_False, elective = l_False;
       if (parser[i][s] == "Core" || parser[i][s] == "C" ||
           parser[i][s] == "Y") {
         course.addProgram(j);
-        assignmentsThisCourse[FieldType::program].push_back(l_True);
-        assignmentsThisCourse[FieldType::program].push_back(l_False);
+        core = l_True;
       } else if (parser[i][s] == "Elective" || parser[i][s] == "E") {
         course.addProgram(j + 1);
-        assignmentsThisCourse[FieldType::program].push_back(l_False);
-        assignmentsThisCourse[FieldType::program].push_back(l_True);
-      } else if (parser[i][s] == "No" || parser[i][s] == "N" ||
-                 parser[i][s] == "") {
-        assignmentsThisCourse[FieldType::program].push_back(l_False);
-        assignmentsThisCourse[FieldType::program].push_back(l_False);
-      } else {
+        elective = l_True;
+      } else if (parser[i][s] != "No" && parser[i][s] != "N" &&
+                 parser[i][s] != "") {
         LOG(ERROR) << "Input contains invalid Program type (should be "
                       "'Core', 'Elective', or 'No')";
+        continue;
       }
+      index.setExistingAssignment(c, FieldType::program, j, core);
+      index.setExistingAssignment(c, FieldType::program, j + 1, elective);
     }
 
     std::string classroomStr = parser[i]["classroom"];
     std::string slotStr = parser[i]["slot"];
     bool foundClassroom = false;
     bool foundSlot = false;
-    assignmentsThisCourse[FieldType::classroom].resize(
-        timetabler->data.classrooms.size(), l_Undef);
-    assignmentsThisCourse[FieldType::slot].resize(timetabler->data.slots.size(),
-                                                  l_Undef);
     if (classroomStr != "") {
-      for (unsigned j = 0; j < timetabler->data.classrooms.size(); j++) {
-        if (timetabler->data.classrooms[j].getName() == classroomStr) {
-          assignmentsThisCourse[FieldType::classroom][j] = l_True;
+      for (unsigned j = 0; j < data.classrooms.size(); j++) {
+        if (data.classrooms[j].getName() == classroomStr) {
+          index.setExistingAssignment(c, FieldType::classroom, j, l_True);
           foundClassroom = true;
           course.addClassroom(j);
           continue;
         }
-        assignmentsThisCourse[FieldType::classroom][j] = l_False;
+        index.setExistingAssignment(c, FieldType::classroom, j, l_False);
       }
       if (!foundClassroom) {
         LOG(ERROR) << "Input contains invalid Classroom name";
       }
     }
     if (slotStr != "") {
-      for (unsigned j = 0; j < timetabler->data.slots.size(); j++) {
-        if (timetabler->data.slots[j].getName() == slotStr) {
-          assignmentsThisCourse[FieldType::slot][j] = l_True;
+      for (unsigned j = 0; j < data.slots.size(); j++) {
+        if (data.slots[j].getName() == slotStr) {
+          index.setExistingAssignment(c, FieldType::slot, j, l_True);
           foundSlot = true;
           course.addSlot(j);
           continue;
         }
-        assignmentsThisCourse[FieldType::slot][j] = l_False;
+        index.setExistingAssignment(c, FieldType::slot, j, l_False);
       }
       if (!foundSlot) {
         LOG(ERROR) << "Input contains invalid Slot name";
       }
     }
-    timetabler->data.courses.push_back(course);
-    timetabler->data.existingAssignmentVars.push_back(assignmentsThisCourse);
+    data.courses.push_back(course);
+  }
+}
+
+/**
+ * @brief      Finds a field value by its name.
+ *
+ * @param[in]  values  The field values
+ * @param[in]  name    The name
+ *
+ * @tparam     T       The type of the field values
+ *
+ * @return     The index of the field value, or -1 if there is none
+ */
+template <typename T>
+static int findByName(std::vector<T> &values, const std::string &name) {
+  for (unsigned i = 0; i < values.size(); i++) {
+    if (values[i].getName() == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief      Parses a timetable from a file in the format of the input, such
+ * as a previous output, and uses it as phase hints for the solver.
+ *
+ * The courses are matched by their names. A field that is empty or has an
+ * unknown value is not hinted. The variables must already have been added,
+ * and ConstraintAdder::addSymmetryBreaking() must be called afterwards, so
+ * that it can reorder the hints of interchangeable values.
+ *
+ * @param[in]  file  The file containing the timetable
+ */
+void Parser::parseWarmStart(std::string file) {
+  csv::Parser parser(file);
+  Data &data = timetabler->data;
+  for (unsigned i = 0; i < parser.rowCount(); ++i) {
+    int c = findByName(data.courses, parser[i]["name"]);
+    if (c == -1) {
+      LOG(WARNING) << "Warm start contains unknown Course "
+                   << parser[i]["name"];
+      continue;
+    }
+    addPhaseHints(c, FieldType::instructor,
+                  findByName(data.instructors, parser[i]["instructor"]));
+    addPhaseHints(c, FieldType::segment,
+                  findByName(data.segments, parser[i]["segment"]));
+    std::string isMinorStr = parser[i]["is_minor"];
+    if (isMinorStr == "Y") {
+      isMinorStr = "Yes";
+    } else if (isMinorStr == "N" || isMinorStr == "") {
+      isMinorStr = "No";
+    }
+    addPhaseHints(c, FieldType::isMinor,
+                  findByName(data.isMinors, isMinorStr));
+    for (unsigned j = 0; j < data.programs.size(); j += 2) {
+      std::string s = parser[i][data.programs[j].getName()];
+      if (s == "Core" || s == "C" || s == "Y") {
+        addPhaseHint(c, FieldType::program, j, true);
+        addPhaseHint(c, FieldType::program, j + 1, false);
+      } else if (s == "Elective" || s == "E") {
+        addPhaseHint(c, FieldType::program, j, false);
+        addPhaseHint(c, FieldType::program, j + 1, true);
+      } else if (s == "No" || s == "N" || s == "") {
+        addPhaseHint(c, FieldType::program, j, false);
+        addPhaseHint(c, FieldType::program, j + 1, false);
+      }
+    }
+    addPhaseHints(c, FieldType::classroom,
+                  findByName(data.classrooms, parser[i]["classroom"]));
+    addPhaseHints(c, FieldType::slot,
+                  findByName(data.slots, parser[i]["slot"]));
+  }
+}
+
+/**
+ * @brief      Hints that a Course has one field value of a FieldType, and
+ * none of the others.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value, or -1 to add no hints
+ */
+void Parser::addPhaseHints(int course, FieldType fieldType, int value) {
+  if (value == -1) {
+    return;
+  }
+  const FieldValueIndex &index = timetabler->data.fieldValueIndex;
+  for (unsigned j = 0; j < index.getValueCount(fieldType); j++) {
+    addPhaseHint(course, fieldType, j, static_cast<int>(j) == value);
+  }
+}
+
+/**
+ * @brief      Hints the value of the variable of a field value of a Course,
+ * if it has one.
+ *
+ * @param[in]  course     The course
+ * @param[in]  fieldType  The field type
+ * @param[in]  value      The index of the field value
+ * @param[in]  hint       The hinted value of the variable
+ */
+void Parser::addPhaseHint(int course, FieldType fieldType, int value,
+                          bool hint) {
+  Var v = timetabler->data.fieldValueIndex.getVar(course, fieldType, value);
+  if (v != var_Undef) {
+    timetabler->data.phaseHints.push_back(mkLit(v, !hint));
   }
 }
 
@@ -266,8 +495,8 @@ bool Parser::verify() {
     for (auto course2 : timetabler->data.courses) {
       if (course1.getName() == course2.getName()) continue;
       bool segementIntersecting =
-          timetabler->data.segments[course1.getSegment()].isIntersecting(
-              timetabler->data.segments[course2.getSegment()]);
+          timetabler->data
+              .segmentIntersections[course1.getSegment()][course2.getSegment()];
       bool classroomSame = (course1.getClassroom() != -1 &&
                             course1.getClassroom() == course2.getClassroom());
       // bool slotSame =
@@ -275,8 +504,8 @@ bool Parser::verify() {
       //     course2.getSlot());
       bool slotIntersecting =
           (course1.getSlot() != -1 && course2.getSlot() != -1)
-              ? (timetabler->data.slots[course1.getSlot()].isIntersecting(
-                    timetabler->data.slots[course2.getSlot()]))
+              ? timetabler->data
+                    .slotIntersections[course1.getSlot()][course2.getSlot()]
               : false;
       if (segementIntersecting && slotIntersecting) {
         if (course1.getInstructor() == course2.getInstructor()) {
@@ -336,38 +565,77 @@ bool Parser::verify() {
 }
 
 /**
- * @brief      Requests for variables to be added to the solver and stores the
- * data.
+ * @brief      Fills the domain store with the field values that are fixed or
+ * forbidden for every Course.
+ *
+ * The existing assignments of a FieldType whose existing assignments are hard
+ * hold in every solution, so the values assigned True are fixed, and the
+ * values assigned False are forbidden, unless Data::session is set. If the
+ * Segments keep their length, the Segments of a different length than the
+ * Segment given to a Course are also forbidden. A Classroom smaller than the
+ * class size of a Course is forbidden for it, unless the Course is fixed to
+ * that Classroom. This must be called after parsing the fields and the input,
+ * and before adding the variables.
  */
-void Parser::addVars() {
-  for (Course c : timetabler->data.courses) {
-    std::vector<std::vector<Var>> courseVars;
-    courseVars.resize(Global::FIELD_COUNT);
-    for (Classroom cr : timetabler->data.classrooms) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::classroom].push_back(v);
-    }
-    for (Instructor i : timetabler->data.instructors) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::instructor].push_back(v);
-    }
-    for (IsMinor i : timetabler->data.isMinors) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::isMinor].push_back(v);
+void Parser::reduceDomains() {
+  Data &data = timetabler->data;
+  data.domains.clear();
+  const FieldValueIndex &index = data.fieldValueIndex;
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    if (data.keepSegmentLength) {
+      for (unsigned k = 0; k < data.segments.size(); k++) {
+        if (index.getExistingAssignment(i, FieldType::segment, k) != l_True) {
+          continue;
+        }
+        for (unsigned l = 0; l < data.segments.size(); l++) {
+          if (data.segments[l].length() != data.segments[k].length()) {
+            data.domains.setValue(i, FieldType::segment, l, l_False);
+          }
+        }
+      }
     }
-    for (Program p : timetabler->data.programs) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::program].push_back(v);
+    for (unsigned j = 0; j < Global::FIELD_COUNT; j++) {
+      // in a session, the existing assignments can be changed by assumptions
+      if (data.existingAssignmentWeights[j] >= 0 || data.session) {
+        continue;
+      }
+      for (unsigned k = 0; k < index.getValueCount(FieldType(j)); k++) {
+        lbool existing = index.getExistingAssignment(i, FieldType(j), k);
+        if (existing != l_Undef) {
+          data.domains.setValue(i, FieldType(j), k, existing);
+        }
+      }
     }
-    for (Segment s : timetabler->data.segments) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::segment].push_back(v);
+    for (unsigned k = 0; k < data.classrooms.size(); k++) {
+      if (data.classrooms[k].getSize() < data.courses[i].getClassSize() &&
+          !data.domains.isFixed(i, FieldType::classroom, k)) {
+        data.domains.setValue(i, FieldType::classroom, k, l_False);
+      }
     }
-    for (Slot s : timetabler->data.slots) {
-      Var v = timetabler->newVar();
-      courseVars[FieldType::slot].push_back(v);
+  }
+}
+
+/**
+ * @brief      Requests for variables to be added to the solver and stores the
+ * data.
+ *
+ * No variable is added for a field value that is forbidden by the domain
+ * store, and its variable is left as var_Undef.
+ */
+void Parser::addVars() {
+  // the order in which the variables of the FieldTypes are added
+  const FieldType fieldTypes[] = {FieldType::classroom, FieldType::instructor,
+                                  FieldType::isMinor,   FieldType::program,
+                                  FieldType::segment,   FieldType::slot};
+  FieldValueIndex &index = timetabler->data.fieldValueIndex;
+  for (unsigned c = 0; c < timetabler->data.courses.size(); c++) {
+    for (FieldType fieldType : fieldTypes) {
+      for (unsigned j = 0; j < index.getValueCount(fieldType); j++) {
+        if (!timetabler->data.domains.isForbidden(c, fieldType, j)) {
+          index.setVar(c, fieldType, j, timetabler->newVar());
+        }
+      }
     }
-    timetabler->data.fieldValueVars.push_back(courseVars);
 
     std::vector<Var> highLevelCourseVars;
     for (unsigned i = 0; i < Global::FIELD_COUNT; ++i) {
@@ -375,6 +643,28 @@ void Parser::addVars() {
       highLevelCourseVars.push_back(v);
     }
     timetabler->data.highLevelVars.push_back(highLevelCourseVars);
+
+    if (timetabler->data.timeEncoding == TimeEncoding::occupancy) {
+      std::vector<Var> occupancyCourseVars;
+      for (unsigned i = 0; i < timetabler->data.periodCount *
+                                   timetabler->data.segmentUnitCount;
+           i++) {
+        Var v = timetabler->newVar();
+        occupancyCourseVars.push_back(v);
+      }
+      timetabler->data.occupancyVars.push_back(occupancyCourseVars);
+    }
+
+    if (timetabler->data.timeEncoding == TimeEncoding::pairwise &&
+        timetabler->data.segmentEncoding == SegmentEncoding::order) {
+      std::vector<Var> startCourseVars, endCourseVars;
+      for (unsigned i = 0; i + 1 < timetabler->data.segmentUnitCount; i++) {
+        startCourseVars.push_back(timetabler->newVar());
+        endCourseVars.push_back(timetabler->newVar());
+      }
+      timetabler->data.segmentStartVars.push_back(startCourseVars);
+      timetabler->data.segmentEndVars.push_back(endCourseVars);
+    }
   }
 
   timetabler->data.predefinedConstraintVars.resize(
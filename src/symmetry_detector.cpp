@@ -0,0 +1,125 @@
+#include "symmetry_detector.h"
+
+#include <vector>
+#include "core/SolverTypes.h"
+#include "data.h"
+#include "global.h"
+
+using namespace NSPACE;
+
+/**
+ * @brief      Constructs the SymmetryDetector object, and finds the classes of
+ * interchangeable field values.
+ *
+ * The Data object must already contain the variables and the existing
+ * assignments, and all custom constraints must have been encoded.
+ *
+ * @param      data  The data
+ */
+SymmetryDetector::SymmetryDetector(Data *data) {
+  this->data = data;
+  detect();
+}
+
+/**
+ * @brief      Checks if two field values have the same properties that the
+ * constraints depend on.
+ *
+ * @param[in]  fieldType  The field type, which is a Classroom or a Slot
+ * @param[in]  value1     The index of the first field value
+ * @param[in]  value2     The index of the second field value
+ *
+ * @return     True if the properties are the same, False otherwise
+ */
+bool SymmetryDetector::haveSameProperties(FieldType fieldType, int value1,
+                                          int value2) {
+  if (fieldType == FieldType::classroom) {
+    return data->classrooms[value1].getSize() ==
+           data->classrooms[value2].getSize();
+  }
+  // Slots covering the same time periods intersect the same Slots
+  return data->slotPeriods[value1] == data->slotPeriods[value2] &&
+         data->slots[value1].isMinorSlot() ==
+             data->slots[value2].isMinorSlot() &&
+         data->slots[value1].isMorningSlot() ==
+             data->slots[value2].isMorningSlot();
+}
+
+/**
+ * @brief      Checks if every Course has the same existing assignment and
+ * domain for two field values.
+ *
+ * @param[in]  fieldType  The field type
+ * @param[in]  value1     The index of the first field value
+ * @param[in]  value2     The index of the second field value
+ *
+ * @return     True if the assignments are the same, False otherwise
+ */
+bool SymmetryDetector::haveSameAssignments(FieldType fieldType, int value1,
+                                           int value2) {
+  const FieldValueIndex &index = data->fieldValueIndex;
+  for (unsigned i = 0; i < data->courses.size(); i++) {
+    if (index.getExistingAssignment(i, fieldType, value1) !=
+            index.getExistingAssignment(i, fieldType, value2) ||
+        data->domains.getValue(i, fieldType, value1) !=
+            data->domains.getValue(i, fieldType, value2)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief      Finds the classes of interchangeable field values.
+ *
+ * Each field value joins the class of the first earlier value that it is
+ * interchangeable with, so the values of a class are in increasing order.
+ * Classes with a single value are not stored.
+ */
+void SymmetryDetector::detect() {
+  classes.clear();
+  classes.resize(Global::FIELD_COUNT);
+  const FieldType fieldTypes[] = {FieldType::classroom, FieldType::slot};
+  for (FieldType fieldType : fieldTypes) {
+    unsigned valueCount = (fieldType == FieldType::classroom)
+                              ? data->classrooms.size()
+                              : data->slots.size();
+    const std::vector<bool> &listed = data->listedValues[fieldType];
+    std::vector<std::vector<int>> fieldClasses;
+    for (unsigned i = 0; i < valueCount; i++) {
+      if (i < listed.size() && listed[i]) {
+        continue;
+      }
+      bool added = false;
+      for (std::vector<int> &fieldClass : fieldClasses) {
+        if (haveSameProperties(fieldType, fieldClass[0], i) &&
+            haveSameAssignments(fieldType, fieldClass[0], i)) {
+          fieldClass.push_back(i);
+          added = true;
+          break;
+        }
+      }
+      if (!added) {
+        fieldClasses.push_back(std::vector<int>(1, i));
+      }
+    }
+    for (const std::vector<int> &fieldClass : fieldClasses) {
+      if (fieldClass.size() > 1) {
+        classes[fieldType].push_back(fieldClass);
+      }
+    }
+  }
+}
+
+/**
+ * @brief      Gets the classes of interchangeable field values of a FieldType.
+ *
+ * @param[in]  fieldType  The field type
+ *
+ * @return     The classes, each with the indices of its field values in
+ * increasing order
+ */
+const std::vector<std::vector<int>> &SymmetryDetector::getClasses(
+    FieldType fieldType) {
+  return classes[fieldType];
+}
@@ -1,13 +1,25 @@
 #include "timetabler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 #include "MaxSATFormula.h"
 #include "cclause.h"
+#include "clause_sink.h"
+#include "classroom_matcher.h"
 #include "clauses.h"
 #include "core/SolverTypes.h"
+#include "encoding_context.h"
+#include "formula_components.h"
 #include "mtl/Vec.h"
 #include "tsolver.h"
 #include "utils.h"
@@ -21,8 +33,49 @@ Timetabler::Timetabler() {
   solver = new TSolver(1, _CARD_TOTALIZER_);
   formula = new MaxSATFormula();
   formula->setProblemType(_WEIGHTED_);
+  context = new EncodingContext(new FormulaClauseSink(formula));
+  clauseBuffer = nullptr;
+  splitComponents = true;
+  formulaLoaded = false;
+  components = nullptr;
+  cost = 0;
+  timedOut = false;
+  matchingRaisedCost = false;
 }
 
+/**
+ * @brief      Sets the ClauseSink to which all clauses are added, instead of
+ * the formula of the solver.
+ *
+ * The Timetabler takes ownership of the ClauseSink.
+ *
+ * @param      sink  The clause sink
+ */
+void Timetabler::setClauseSink(ClauseSink *sink) {
+  context->setClauseSink(sink);
+  clauseBuffer = nullptr;
+}
+
+/**
+ * @brief      Adds all clauses to a buffer instead of the formula of the
+ * solver, so that the independent components of the formula are solved
+ * separately by solve(), each by the solvers of Data::portfolio.
+ *
+ * @param[in]  split  False to solve the formula as a single component
+ */
+void Timetabler::bufferClauses(bool split) {
+  splitComponents = split;
+  clauseBuffer = new BufferClauseSink();
+  context->setClauseSink(clauseBuffer);
+}
+
+/**
+ * @brief      Gets the EncodingContext in which the problem is encoded.
+ *
+ * @return     The encoding context
+ */
+EncodingContext *Timetabler::getEncodingContext() { return context; }
+
 /**
  * @brief      Adds clauses to the solver with specified weights.
  *
@@ -34,12 +87,8 @@ Timetabler::Timetabler() {
  */
 void Timetabler::addClauses(const std::vector<CClause> &clauses, int weight) {
   for (unsigned i = 0; i < clauses.size(); i++) {
-    vec<Lit> clauseVec;
-    std::vector<Lit> clauseVector = clauses[i].getLits();
-    for (unsigned j = 0; j < clauseVector.size(); j++) {
-      clauseVec.push(clauseVector[j]);
-    }
-    addToFormula(clauseVec, weight);
+    const std::vector<Lit> &lits = clauses[i].getLits();
+    context->addClause(lits.data(), lits.size(), weight);
   }
 }
 
@@ -50,10 +99,8 @@ void Timetabler::addClauses(const std::vector<CClause> &clauses, int weight) {
 void Timetabler::addHighLevelClauses() {
   for (unsigned i = 0; i < Global::FIELD_COUNT; i++) {
     for (unsigned j = 0; j < data.highLevelVars.size(); j++) {
-      vec<Lit> highLevelClause;
-      highLevelClause.clear();
-      highLevelClause.push(mkLit(data.highLevelVars[j][i], false));
-      addToFormula(highLevelClause, data.highLevelVarWeights[i]);
+      addSelectorClause(mkLit(data.highLevelVars[j][i], false),
+                        data.highLevelVarWeights[i]);
     }
   }
 }
@@ -71,11 +118,12 @@ void Timetabler::addHighLevelClauses() {
  */
 void Timetabler::addHighLevelConstraintClauses(PredefinedClauses clauseType,
                                                const int course) {
+  int weight = data.predefinedClausesWeights[clauseType];
   if (course == -1) {
     assert(data.predefinedConstraintVars[clauseType].size() == 1);
     Lit l = mkLit(data.predefinedConstraintVars[clauseType][0], false);
-    if (data.predefinedClausesWeights[clauseType] != 0) {
-      addToFormula(l, data.predefinedClausesWeights[clauseType]);
+    if (weight != 0) {
+      addSelectorClause(l, weight);
     } else {
       addToFormula(l, -1);
     }
@@ -83,8 +131,8 @@ void Timetabler::addHighLevelConstraintClauses(PredefinedClauses clauseType,
     assert(data.predefinedConstraintVars[clauseType].size() ==
            data.courses.size());
     Lit l = mkLit(data.predefinedConstraintVars[clauseType][course], false);
-    if (data.predefinedClausesWeights[clauseType] != 0) {
-      addToFormula(l, data.predefinedClausesWeights[clauseType]);
+    if (weight != 0) {
+      addSelectorClause(l, weight);
     } else {
       addToFormula(l, -1);
     }
@@ -105,7 +153,7 @@ void Timetabler::addHighLevelConstraintClauses(PredefinedClauses clauseType,
 void Timetabler::addHighLevelCustomConstraintClauses(int index, int weight) {
   Lit l = mkLit(data.customConstraintVars[index], false);
   if (weight != 0) {
-    addToFormula(l, weight);
+    addSelectorClause(l, weight);
   } else {
     addToFormula(l, -1);
   }
@@ -114,20 +162,39 @@ void Timetabler::addHighLevelCustomConstraintClauses(int index, int weight) {
 /**
  * @brief      Adds unit clauses corresponding to existing assignments given in
  * the input to the solver.
+ *
+ * If Data::session is set, the clauses of the existing assignment of a
+ * FieldType of a Course are guarded by a selector variable in
+ * Data::existingAssignmentSelectors instead, which solve() assumes by default.
  */
 void Timetabler::addExistingAssignments() {
-  for (unsigned i = 0; i < data.existingAssignmentVars.size(); i++) {
-    for (unsigned j = 0; j < data.existingAssignmentVars[i].size(); j++) {
-      for (unsigned k = 0; k < data.existingAssignmentVars[i][j].size(); k++) {
-        if (data.existingAssignmentVars[i][j][k] == l_Undef) {
+  const FieldValueIndex &index = data.fieldValueIndex;
+  data.existingAssignmentSelectors.assign(
+      index.getCourseCount(), std::vector<Var>(Global::FIELD_COUNT, var_Undef));
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    for (unsigned j = 0; j < Global::FIELD_COUNT; j++) {
+      for (unsigned k = 0; k < index.getValueCount(FieldType(j)); k++) {
+        lbool existing = index.getExistingAssignment(i, FieldType(j), k);
+        Var v = index.getVar(i, FieldType(j), k);
+        // a forbidden value has no variable, and is always False, so its
+        // existing assignment needs no clause
+        if (existing == l_Undef || v == var_Undef) {
           continue;
         }
         vec<Lit> clause;
         clause.clear();
-        if (data.existingAssignmentVars[i][j][k] == l_True) {
-          clause.push(mkLit(data.fieldValueVars[i][j][k]));
+        if (existing == l_True) {
+          clause.push(mkLit(v));
         } else {
-          clause.push(~mkLit(data.fieldValueVars[i][j][k]));
+          clause.push(~mkLit(v));
+        }
+        if (data.session && data.existingAssignmentWeights[j] != 0) {
+          Var &selector = data.existingAssignmentSelectors[i][j];
+          if (selector == var_Undef) {
+            selector = newVar();
+            sessionAssumptions.push_back(mkLit(selector, false));
+          }
+          clause.push(mkLit(selector, true));
         }
         addToFormula(clause, data.existingAssignmentWeights[j]);
       }
@@ -145,11 +212,19 @@ void Timetabler::addExistingAssignments() {
  * @param[in]  weight  The weight
  */
 void Timetabler::addToFormula(vec<Lit> &input, int weight) {
-  if (weight < 0) {
-    formula->addHardClause(input);
-  } else if (weight > 0) {
-    formula->addSoftClause(weight, input);
-  }
+  context->addClause(input, input.size(), weight);
+}
+
+/**
+ * @brief      Add a clause, given by its literals, with the given weight to the
+ * formula.
+ *
+ * @param[in]  lits    Pointer to the first literal of the clause
+ * @param[in]  size    The number of literals in the clause
+ * @param[in]  weight  The weight
+ */
+void Timetabler::addToFormula(const Lit *lits, unsigned size, int weight) {
+  context->addClause(lits, size, weight);
 }
 
 /**
@@ -174,19 +249,237 @@ void Timetabler::addToFormula(Lit input, int weight) {
  * @param[in]  weight   The weight
  */
 void Timetabler::addClauses(const Clauses &clauses, int weight) {
-  addClauses(clauses.getClauses(), weight);
+  for (unsigned i = 0; i < clauses.size(); i++) {
+    ClauseView clause = clauses.getClause(i);
+    context->addClause(clause.begin(), clause.size(), weight);
+  }
+}
+
+/**
+ * @brief      Adds clauses that must hold only if a guard variable is True.
+ *
+ * See EncodingContext::addGuardedClauses.
+ *
+ * @param[in]  guard    The guard variable
+ * @param[in]  clauses  The clauses
+ * @param[in]  weight   The weight
+ */
+void Timetabler::addGuardedClauses(const Var &guard, const Clauses &clauses,
+                                   int weight) {
+  context->addGuardedClauses(guard, clauses, weight);
+}
+
+/**
+ * @brief      Adds a constraint that at most k of the given literals are True.
+ *
+ * The constraint is encoded with EncodingContext::atMostK, instead of being
+ * expanded into clauses over every k + 1 of the literals, and its clauses
+ * are guarded by the selector variable of the constraint as given by
+ * getGuard(). The unit clause of the selector variable with the weight is
+ * added by the caller, like for the other constraints. A zero weight implies
+ * that the constraint is not added to the solver.
+ *
+ * @param[in]  lits      The literals
+ * @param[in]  k         The maximum number of True literals
+ * @param[in]  selector  The selector variable of the constraint
+ * @param[in]  weight    The weight of the constraint
+ */
+void Timetabler::addCardinality(const std::vector<Lit> &lits, unsigned k,
+                                const Var &selector, int weight) {
+  if (weight == 0) {
+    return;
+  }
+  context->addGuardedClauses(getGuard(selector, weight),
+                             context->atMostK(lits, k, data.amoEncoding), -1);
+}
+
+/**
+ * @brief      Gets the guard with which the clauses of a constraint are added.
+ *
+ * This is the selector variable of the constraint, which is used to explain
+ * which constraints could not be satisfied. If Data::directHardConstraints is
+ * set, hard constraints get no guard, so that their clauses are added as they
+ * are, unless Data::session is set.
+ *
+ * @param[in]  selector  The selector variable of the constraint
+ * @param[in]  weight    The weight of the constraint
+ *
+ * @return     The guard variable, or var_Undef if there is no guard
+ */
+Var Timetabler::getGuard(const Var &selector, int weight) {
+  if (data.directHardConstraints && !data.session && weight < 0) {
+    return var_Undef;
+  }
+  return selector;
+}
+
+/**
+ * @brief      Adds the unit clause of the selector variable of a constraint
+ * with the weight of the constraint.
+ *
+ * If Data::relaxHardConstraints is set, the unit clauses of hard constraints
+ * are instead added by addRelaxedHardClauses(), once the weights of all the
+ * soft clauses are known. If Data::session is set, the selector literals of
+ * hard constraints are assumed by solve() instead, so that the constraints
+ * can be disabled by assumptions.
+ *
+ * @param[in]  l       The selector literal
+ * @param[in]  weight  The weight of the constraint
+ */
+void Timetabler::addSelectorClause(Lit l, int weight) {
+  if (data.relaxHardConstraints && weight < 0) {
+    relaxedSelectors.push_back(l);
+    return;
+  }
+  if (data.session && weight < 0) {
+    sessionAssumptions.push_back(l);
+    return;
+  }
+  addToFormula(l, weight);
 }
 
+/**
+ * @brief      Issues the selector variable of the clauses that break the
+ * symmetries between the values of a class of interchangeable field values.
+ *
+ * An assumption may tell interchangeable values apart, so in a session, the
+ * clauses are guarded by a selector variable that solve() assumes only while
+ * there are no assumptions. Otherwise, the clauses are always added.
+ *
+ * @return     The selector variable, or var_Undef if there is none
+ */
+Var Timetabler::newSymmetrySelector() {
+  if (!data.session) {
+    return var_Undef;
+  }
+  Var selector = newVar();
+  symmetrySelectors.push_back(selector);
+  return selector;
+}
+
+/**
+ * @brief      Gets the literals assumed by solve().
+ *
+ * These are the assumptions, followed by the selector literals that are
+ * assumed by default in a session, except those whose variables are assumed
+ * otherwise. The selectors of the clauses that break symmetries are only
+ * assumed if there are no assumptions.
+ *
+ * @return     The literals
+ */
+std::vector<Lit> Timetabler::getSearchAssumptions() {
+  std::vector<Lit> result = assumptions;
+  for (Lit lit : sessionAssumptions) {
+    bool assumed = false;
+    for (Lit assumption : assumptions) {
+      assumed = assumed || var(assumption) == var(lit);
+    }
+    if (!assumed) {
+      result.push_back(lit);
+    }
+  }
+  if (assumptions.empty()) {
+    for (Var selector : symmetrySelectors) {
+      result.push_back(mkLit(selector, false));
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Adds soft unit clauses for the selector variables of the hard
+ * constraints, if Data::relaxHardConstraints is set.
+ *
+ * Each clause has a weight larger than the total weight of all the other soft
+ * clauses, so that the solver finds the fewest hard constraints that cannot
+ * be satisfied, and only then minimizes the soft penalties. This must be
+ * called after all the other clauses are added.
+ */
+void Timetabler::addRelaxedHardClauses() {
+  uint64_t weight = context->getSoftWeight() + 1;
+  for (unsigned i = 0; i < relaxedSelectors.size(); i++) {
+    context->addClause(&relaxedSelectors[i], 1, weight);
+  }
+  relaxedSelectors.clear();
+}
+
+/**
+ * @brief      Assumes a literal to be True in the following calls of solve(),
+ * replacing an earlier assumption on its variable.
+ *
+ * Assumptions on the variables of field values fix or forbid assignments,
+ * without encoding the problem again. The problem must be encoded with
+ * Data::session set, so that the assumptions cannot conflict with the
+ * clauses that break symmetries, and so that every field value has a
+ * variable. The negation of a selector variable of a hard constraint, in
+ * Data::predefinedConstraintVars or Data::customConstraintVars, disables the
+ * constraint, and the negation of one in Data::existingAssignmentSelectors lets
+ * an existing assignment change. The selector variable of a soft constraint
+ * makes it hard, and its negation disables it, with its weight counted in
+ * the cost.
+ *
+ * @param[in]  lit   The literal
+ */
+void Timetabler::assume(Lit lit) {
+  retract(var(lit));
+  assumptions.push_back(lit);
+}
+
+/**
+ * @brief      Removes the assumption on a variable, if any.
+ *
+ * @param[in]  v     The variable
+ */
+void Timetabler::retract(Var v) {
+  for (unsigned i = 0; i < assumptions.size(); i++) {
+    if (var(assumptions[i]) == v) {
+      assumptions.erase(assumptions.begin() + i);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief      Removes all assumptions.
+ */
+void Timetabler::clearAssumptions() { assumptions.clear(); }
+
 /**
  * @brief      Calls the solver to solve for the constraints.
  *
+ * If Data::deadline is reached, the best model found so far is kept. The
+ * formula is loaded into the solver in the first call, and must not change
+ * afterwards. Later calls keep the SAT solver of the formula, so that they
+ * only differ in their assumptions. The same holds for the solvers of the
+ * components of a buffered formula.
+ *
  * @return     True, if all high level variables were satisfied, False otherwise
  */
 SolverStatus Timetabler::solve() {
-  solver->loadFormula(formula);
-  model = solver->tSearch();
+  matchingRaisedCost = false;
+  if (clauseBuffer != nullptr) {
+    model = solveComponents();
+  } else {
+    if (!formulaLoaded) {
+      while (formula->nVars() < context->nVars()) {
+        formula->newVar();
+      }
+      solver->loadFormula(formula);
+      formulaLoaded = true;
+    }
+    solver->setDeadline(data.deadline);
+    solver->setPhases(data.phaseHints);
+    if (data.progressFd != -1) {
+      solver->setProgressCallback([this](const SolverProgress &progress) {
+        writeProgress(0, 0, progress);
+      });
+    }
+    model = solver->tSearch(getSearchAssumptions());
+    cost = solver->getCost();
+    timedOut = solver->hasTimedOut();
+  }
   if (model.size() == 0) {
-    return SolverStatus::Unsolved;
+    return timedOut ? SolverStatus::TimedOut : SolverStatus::Unsolved;
   }
   if (checkAllTrue(Utils::flattenVector<Var>(data.highLevelVars)) &&
       checkAllTrue(data.predefinedConstraintVars) &&
@@ -196,6 +489,411 @@ SolverStatus Timetabler::solve() {
   return SolverStatus::HighLevelFailed;
 }
 
+/**
+ * @brief      Solves the independent components of the buffered formula, and
+ * merges their models.
+ *
+ * Each component gets its own formula and solvers, which are kept for later
+ * calls. Up to Data::threadCount components are solved at the same time,
+ * each taking the next component that has not been taken yet. Variables that
+ * are in no clause are False. The cost of the model is the sum of the costs
+ * of the components, and it is optimal if no component timed out.
+ *
+ * @return     The model of the formula, which is empty if any component was
+ * unsatisfiable or timed out before a model was found
+ */
+std::vector<lbool> Timetabler::solveComponents() {
+  if (components == nullptr) {
+    components =
+        new FormulaComponents(*clauseBuffer, context->nVars(), splitComponents);
+    componentSolvers.resize(components->size());
+  }
+  LOG(INFO) << "Solving " << components->size() << " independent components";
+  std::vector<Lit> searchAssumptions = getSearchAssumptions();
+  std::vector<std::vector<lbool>> models(components->size());
+  std::vector<uint64_t> costs(components->size(), 0);
+  std::vector<char> timeouts(components->size(), false);
+  std::atomic<unsigned> next(0);
+  auto work = [this, &searchAssumptions, &models, &costs, &timeouts,
+               &next]() {
+    for (unsigned c = next++; c < components->size(); c = next++) {
+      bool componentTimedOut;
+      models[c] =
+          solveComponent(c, searchAssumptions, costs[c], componentTimedOut);
+      timeouts[c] = componentTimedOut;
+    }
+  };
+  unsigned threadCount = std::min<std::size_t>(
+      std::max(data.threadCount, 1u), components->size());
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < threadCount; t++) {
+    threads.push_back(std::thread(work));
+  }
+  work();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  cost = 0;
+  timedOut = false;
+  for (unsigned c = 0; c < components->size(); c++) {
+    if (models[c].size() == 0 && !timeouts[c]) {
+      // an unsatisfiable component makes the whole formula unsatisfiable
+      return std::vector<lbool>();
+    }
+    timedOut = timedOut || timeouts[c];
+  }
+  std::vector<lbool> result(context->nVars(), l_False);
+  for (unsigned c = 0; c < components->size(); c++) {
+    if (models[c].size() == 0) {
+      return std::vector<lbool>();
+    }
+    cost += costs[c];
+    const std::vector<Var> &componentVars = components->getVars(c);
+    for (unsigned i = 0; i < componentVars.size(); i++) {
+      result[componentVars[i]] = models[c][i];
+    }
+  }
+  // assumed variables that are in no clause keep their assumed values
+  for (Lit assumption : searchAssumptions) {
+    if (components->getLocalVar(var(assumption)) == var_Undef) {
+      result[var(assumption)] = sign(assumption) ? l_False : l_True;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief      Solves a component of the buffered formula with the solvers of
+ * Data::portfolio.
+ *
+ * Each solver solves its own copy of the formula of the component on its own
+ * thread. The first solver that finishes stops the others. If all of them
+ * are stopped at Data::deadline, the best model found by any of them is used.
+ * The solvers are made in the first call for the component, and are kept
+ * for later calls, which only differ in their assumptions.
+ *
+ * @param[in]  component          The index of the component
+ * @param[in]  searchAssumptions  The literals assumed by solve()
+ * @param      componentCost      Set to the cost of the model
+ * @param      componentTimedOut  Set to whether every solver was interrupted
+ * at Data::deadline
+ *
+ * @return     The model of the component over its local variables, which is
+ * empty if it was unsatisfiable under the assumptions on its variables or
+ * timed out before a model was found
+ */
+std::vector<lbool> Timetabler::solveComponent(
+    unsigned component, const std::vector<Lit> &searchAssumptions,
+    uint64_t &componentCost, bool &componentTimedOut) {
+  std::vector<Lit> componentAssumptions =
+      getComponentLits(*components, component, searchAssumptions);
+  std::vector<Lit> componentPhases =
+      getComponentLits(*components, component, data.phaseHints);
+  std::vector<TSolver *> &solvers = componentSolvers[component];
+  unsigned solverCount = data.portfolio.size();
+  if (solvers.empty()) {
+    solvers.resize(solverCount);
+    for (unsigned i = 0; i < solverCount; i++) {
+      solvers[i] = new TSolver(1, _CARD_TOTALIZER_);
+      configureSolver(solvers[i], i);
+      if (data.progressFd != -1) {
+        solvers[i]->setProgressCallback(
+            [this, component, i](const SolverProgress &progress) {
+              writeProgress(component, i, progress);
+            });
+      }
+      // the solver owns the formula
+      solvers[i]->loadFormula(getComponentFormula(*components, component));
+    }
+  }
+  for (unsigned i = 0; i < solverCount; i++) {
+    solvers[i]->setDeadline(data.deadline);
+    solvers[i]->setPhases(componentPhases);
+  }
+  std::vector<std::vector<lbool>> models(solverCount);
+  std::atomic<int> winner(-1);
+  auto work = [&solvers, &models, &winner, &componentAssumptions](unsigned i) {
+    models[i] = solvers[i]->tSearch(componentAssumptions);
+    int none = -1;
+    if (!solvers[i]->hasTimedOut() && winner.compare_exchange_strong(none, i)) {
+      for (unsigned j = 0; j < solvers.size(); j++) {
+        if (j != i) {
+          solvers[j]->interrupt();
+        }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < solverCount; i++) {
+    threads.push_back(std::thread(work, i));
+  }
+  work(0);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  int best = winner;
+  componentTimedOut = (best == -1);
+  if (best == -1) {
+    best = 0;
+    for (unsigned i = 1; i < solverCount; i++) {
+      if (models[i].size() != 0 &&
+          (models[best].size() == 0 ||
+           solvers[i]->getCost() < solvers[best]->getCost())) {
+        best = i;
+      }
+    }
+  }
+  componentCost = solvers[best]->getCost();
+  return models[best];
+}
+
+/**
+ * @brief      Builds the formula of a component of the buffered formula.
+ *
+ * The variables of the component are renumbered to its local variables.
+ *
+ * @param[in]  components  The components of the formula
+ * @param[in]  component   The index of the component
+ *
+ * @return     A pointer to the formula
+ */
+MaxSATFormula *Timetabler::getComponentFormula(
+    const FormulaComponents &components, unsigned component) {
+  MaxSATFormula *componentFormula = new MaxSATFormula();
+  componentFormula->setProblemType(_WEIGHTED_);
+  for (unsigned i = 0; i < components.getVars(component).size(); i++) {
+    componentFormula->newVar();
+  }
+  FormulaClauseSink sink(componentFormula);
+  std::vector<Lit> lits;
+  for (unsigned i : components.getClauses(component)) {
+    const Lit *clause = clauseBuffer->getClause(i);
+    lits.clear();
+    for (unsigned j = 0; j < clauseBuffer->getClauseSize(i); j++) {
+      lits.push_back(
+          mkLit(components.getLocalVar(var(clause[j])), sign(clause[j])));
+    }
+    sink.addClause(lits.data(), lits.size(), clauseBuffer->getWeight(i));
+  }
+  return componentFormula;
+}
+
+/**
+ * @brief      Gets the literals over the variables of a component, renumbered
+ * to its local variables.
+ *
+ * @param[in]  components  The components of the formula
+ * @param[in]  component   The index of the component
+ * @param[in]  lits        The literals
+ *
+ * @return     The literals whose variables are in the component
+ */
+std::vector<Lit> Timetabler::getComponentLits(
+    const FormulaComponents &components, unsigned component,
+    const std::vector<Lit> &lits) {
+  const std::vector<Var> &componentVars = components.getVars(component);
+  std::vector<Lit> componentLits;
+  for (Lit lit : lits) {
+    Var localVar = components.getLocalVar(var(lit));
+    if (localVar != var_Undef &&
+        static_cast<unsigned>(localVar) < componentVars.size() &&
+        componentVars[localVar] == var(lit)) {
+      componentLits.push_back(mkLit(localVar, sign(lit)));
+    }
+  }
+  return componentLits;
+}
+
+/**
+ * @brief      Configures a solver of the portfolio.
+ *
+ * @param      componentSolver  The solver
+ * @param[in]  index            The index of the solver in Data::portfolio
+ */
+void Timetabler::configureSolver(TSolver *componentSolver, unsigned index) {
+  switch (data.portfolio[index]) {
+    case SolverConfiguration::stratified:
+      break;
+    case SolverConfiguration::unstratified:
+      componentSolver->setStratification(false);
+      break;
+    case SolverConfiguration::randomized:
+      componentSolver->setRandomSeed(index + 1);
+      break;
+  }
+}
+
+/**
+ * @brief      Writes the progress of a solver as a JSON line to
+ * Data::progressFd.
+ *
+ * The upper bound is null until a model is found.
+ *
+ * @param[in]  component  The index of the component of the solver, which is
+ * 0 if the formula is not split
+ * @param[in]  index      The index of the solver in Data::portfolio
+ * @param[in]  progress   The progress
+ */
+void Timetabler::writeProgress(unsigned component, unsigned index,
+                               const SolverProgress &progress) {
+  std::ostringstream line;
+  line << "{\"component\":" << component << ",\"solver\":" << index
+       << ",\"elapsed\":" << progress.elapsed
+       << ",\"lb\":" << progress.lowerBound << ",\"ub\":";
+  if (progress.upperBound == UINT64_MAX) {
+    line << "null";
+  } else {
+    line << progress.upperBound;
+  }
+  line << ",\"cores\":" << progress.cores
+       << ",\"avg_core_size\":" << progress.averageCoreSize
+       << ",\"min_weight\":" << progress.minWeight
+       << ",\"sat_calls\":" << progress.satCalls
+       << ",\"memory_mb\":" << progress.memory
+       << ",\"finished\":" << (progress.finished ? "true" : "false") << "}\n";
+  std::string text = line.str();
+  std::lock_guard<std::mutex> lock(progressMutex);
+  const char *buffer = text.data();
+  std::size_t remaining = text.size();
+  while (remaining > 0) {
+    ssize_t written = write(data.progressFd, buffer, remaining);
+    if (written <= 0) {
+      return;
+    }
+    buffer += written;
+    remaining -= written;
+  }
+}
+
+/**
+ * @brief      Checks if the model found by solve() is proven to be optimal.
+ *
+ * The cost found by the solver is a lower bound when the Classrooms are
+ * matched after solving, so the model is still optimal if matching did not
+ * raise its cost.
+ *
+ * @return     True if a model was found, solving finished before
+ * Data::deadline, and matching did not raise the cost, False otherwise
+ */
+bool Timetabler::isOptimal() {
+  return model.size() != 0 && !timedOut && !matchingRaisedCost;
+}
+
+/**
+ * @brief      Gets the cost of the model found by solve().
+ *
+ * @return     The sum of the weights of the soft clauses falsified by the
+ * model
+ */
+uint64_t Timetabler::getCost() { return cost; }
+
+/**
+ * @brief      Checks if the Classrooms are assigned after solving instead of
+ * being constrained in the formula.
+ *
+ * This is only done if Data::matchClassrooms is set and the constraint that
+ * a Classroom has at most one Course at a time is hard.
+ *
+ * @return     True if the Classrooms are assigned after solving, False
+ * otherwise
+ */
+bool Timetabler::matchesClassrooms() {
+  return data.matchClassrooms &&
+         data.predefinedClausesWeights
+                 [PredefinedClauses::classroomSingleCourseAtATime] < 0;
+}
+
+/**
+ * @brief      Assigns the Classrooms of the model with a ClassroomMatcher,
+ * given the Slots and Segments of the model.
+ *
+ * The Classroom of each Course in the model is its preferred Classroom, as
+ * it satisfies the other constraints on the Classroom of the Course. The
+ * model is changed to hold the matched Classrooms, and the cost is updated
+ * for the existing assignments of Classrooms that are no longer kept, which
+ * are the only soft clauses that matching can change.
+ *
+ * @return     True if the Classrooms were assigned, or did not need to be,
+ * and False if the formula has to constrain the Classrooms instead
+ */
+bool Timetabler::assignClassrooms() {
+  if (!matchesClassrooms() || model.size() == 0) {
+    return true;
+  }
+  const FieldValueIndex &index = data.fieldValueIndex;
+  unsigned courseCount = index.getCourseCount();
+  std::vector<int> slots(courseCount, -1), segments(courseCount, -1),
+      preferred(courseCount, -1);
+  for (unsigned i = 0; i < courseCount; i++) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::slot); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::slot, j))) {
+        slots[i] = j;
+      }
+    }
+    for (unsigned j = 0; j < index.getValueCount(FieldType::segment); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::segment, j))) {
+        segments[i] = j;
+      }
+    }
+    for (unsigned j = 0; j < index.getValueCount(FieldType::classroom); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::classroom, j))) {
+        preferred[i] = j;
+      }
+    }
+  }
+  ClassroomMatcher matcher(&data, slots, segments, preferred);
+  if (!matcher.match()) {
+    LOG(WARNING) << "Classrooms could not be assigned by matching";
+    return false;
+  }
+  uint64_t solverCost = getExistingAssignmentCost(FieldType::classroom);
+  for (unsigned i = 0; i < courseCount; i++) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::classroom); j++) {
+      Var v = index.getVar(i, FieldType::classroom, j);
+      if (v != var_Undef) {
+        model[v] = (static_cast<int>(j) == matcher.getClassroom(i)) ? l_True
+                                                                     : l_False;
+      }
+    }
+  }
+  uint64_t matchedCost = getExistingAssignmentCost(FieldType::classroom);
+  if (matchedCost > solverCost) {
+    matchingRaisedCost = true;
+  }
+  cost = cost - solverCost + matchedCost;
+  return true;
+}
+
+/**
+ * @brief      Gets the total weight of the soft unit clauses of the existing
+ * assignments of a field that the model does not keep.
+ *
+ * @param[in]  fieldType  The field type
+ *
+ * @return     The total weight
+ */
+uint64_t Timetabler::getExistingAssignmentCost(FieldType fieldType) {
+  int weight = data.existingAssignmentWeights[fieldType];
+  if (weight <= 0) {
+    return 0;
+  }
+  const FieldValueIndex &index = data.fieldValueIndex;
+  uint64_t result = 0;
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    for (unsigned j = 0; j < index.getValueCount(fieldType); j++) {
+      lbool existing = index.getExistingAssignment(i, fieldType, j);
+      Var v = index.getVar(i, fieldType, j);
+      if (existing == l_Undef || v == var_Undef) {
+        continue;
+      }
+      if (isVarTrue(v) != (existing == l_True)) {
+        result += weight;
+      }
+    }
+  }
+  return result;
+}
+
 /**
  * @brief      Checks if a given set of variables are true in the model returned
  * by the solver.
@@ -242,10 +940,11 @@ bool Timetabler::checkAllTrue(const std::vector<std::vector<Var>> &inputs) {
  *
  * @param[in]  v     The variable to be checked
  *
- * @return     True if variable true, False otherwise
+ * @return     True if variable true, False otherwise. A var_Undef, which
+ * stands for a forbidden field value, is never true.
  */
 bool Timetabler::isVarTrue(const Var &v) {
-  if (model.size() == 0) {
+  if (model.size() == 0 || v == var_Undef) {
     return false;
   }
   if (model[v] == l_False) {
@@ -255,29 +954,25 @@ bool Timetabler::isVarTrue(const Var &v) {
 }
 
 /**
- * @brief      Calls the formula to issue a new variable and returns it.
+ * @brief      Calls the encoding context to issue a new variable and returns
+ * it.
+ *
+ * The variables are added to the formula of the solver before solving.
  *
- * @return     The new Var added to the formula
+ * @return     The new Var
  */
-Var Timetabler::newVar() {
-  Var var = formula->nVars();
-  formula->newVar();
-  return var;
-}
+Var Timetabler::newVar() { return context->newVar(); }
 
 /**
- * @brief      Calls the formula to issue a new literal and returns it.
+ * @brief      Calls the encoding context to issue a new literal and returns
+ * it.
  *
  * @param[in]  sign  The sign, whether the literal contains a sign with the
  * variable
  *
- * @return     The Lit corresponding to the new Var added to the formula
+ * @return     The Lit corresponding to the new Var
  */
-Lit Timetabler::newLiteral(bool sign) {
-  Lit p = mkLit(formula->nVars(), sign);
-  formula->newVar();
-  return p;
-}
+Lit Timetabler::newLiteral(bool sign) { return context->newLiteral(sign); }
 
 /**
  * @brief      Prints the result of the problem.
@@ -292,9 +987,26 @@ void Timetabler::printResult(SolverStatus status) {
     displayUnsatisfiedOutputReasons();
     displayChangesInGivenAssignment();
     displayTimeTable();
+  } else if (status == SolverStatus::TimedOut) {
+    LOG(WARNING) << "Not Solved, the time limit was reached before a "
+                    "timetable was found";
   } else {
     LOG(WARNING) << "Not Solved";
   }
+  if (status == SolverStatus::Solved ||
+      status == SolverStatus::HighLevelFailed) {
+    if (isOptimal()) {
+      LOG(INFO) << "Cost of the timetable is " << cost << ", which is optimal";
+    } else if (!timedOut) {
+      LOG(WARNING) << "Cost of the timetable is " << cost
+                   << ", matching the classrooms raised it above the optimum "
+                      "found by the solver, so it is not proven optimal";
+    } else {
+      LOG(WARNING) << "Cost of the timetable is " << cost
+                   << ", the time limit was reached before it was proven "
+                      "optimal";
+    }
+  }
 }
 
 /**
@@ -302,18 +1014,21 @@ void Timetabler::printResult(SolverStatus status) {
  * assignment given by the user as input by the solver
  */
 void Timetabler::displayChangesInGivenAssignment() {
-  for (unsigned i = 0; i < data.existingAssignmentVars.size(); i++) {
-    for (unsigned j = 0; j < data.existingAssignmentVars[i].size(); j++) {
-      for (unsigned k = 0; k < data.existingAssignmentVars[i][j].size(); k++) {
-        if (data.existingAssignmentVars[i][j][k] == l_True &&
-            model[data.fieldValueVars[i][j][k]] == l_False) {
+  const FieldValueIndex &index = data.fieldValueIndex;
+  for (unsigned i = 0; i < index.getCourseCount(); i++) {
+    for (unsigned j = 0; j < Global::FIELD_COUNT; j++) {
+      for (unsigned k = 0; k < index.getValueCount(FieldType(j)); k++) {
+        lbool existing = index.getExistingAssignment(i, FieldType(j), k);
+        // a forbidden value has no variable, and is always False
+        Var v = index.getVar(i, FieldType(j), k);
+        lbool value = (v == var_Undef) ? l_False : model[v];
+        if (existing == l_True && value == l_False) {
           LOG(WARNING) << "Value of field "
                        << Utils::getFieldTypeName(FieldType(j)) << " "
                        << Utils::getFieldName(FieldType(j), k, data)
                        << " for course " << data.courses[i].getName()
                        << " changed from 'True' to 'False'";
-        } else if (data.existingAssignmentVars[i][j][k] == l_False &&
-                   model[data.fieldValueVars[i][j][k]] == l_True) {
+        } else if (existing == l_False && value == l_True) {
           LOG(WARNING) << "Value of field "
                        << Utils::getFieldTypeName(FieldType(j)) << " "
                        << Utils::getFieldName(FieldType(j), k, data)
@@ -329,41 +1044,36 @@ void Timetabler::displayChangesInGivenAssignment() {
  * @brief      Displays the generated time table.
  */
 void Timetabler::displayTimeTable() {
+  const FieldValueIndex &index = data.fieldValueIndex;
   for (unsigned i = 0; i < data.courses.size(); i++) {
     LOG(INFO) << "Course : " << data.courses[i].getName();
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::slot].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::slot][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::slot); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::slot, j))) {
         LOG(INFO) << "Slot : " << data.slots[j].getName();
       }
     }
-    for (unsigned j = 0;
-         j < data.fieldValueVars[i][FieldType::instructor].size(); j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::instructor][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::instructor); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::instructor, j))) {
         LOG(INFO) << "Instructor : " << data.instructors[j].getName();
       }
     }
-    for (unsigned j = 0;
-         j < data.fieldValueVars[i][FieldType::classroom].size(); j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::classroom][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::classroom); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::classroom, j))) {
         LOG(INFO) << "Classroom : " << data.classrooms[j].getName();
       }
     }
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::segment].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::segment][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::segment); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::segment, j))) {
         LOG(INFO) << "Segment : " << data.segments[j].getName();
       }
     }
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::isMinor].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::isMinor][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::isMinor); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::isMinor, j))) {
         LOG(INFO) << "Is Minor : " << data.isMinors[j].getName();
       }
     }
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::program].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::program][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::program); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::program, j))) {
         LOG(INFO) << "Program : " << data.programs[j].getNameWithType();
       }
     }
@@ -384,50 +1094,45 @@ void Timetabler::writeOutput(std::string fileName) {
     fileObject << data.programs[i].getName() << ",";
   }
   fileObject << "classroom,slot" << std::endl;
+  const FieldValueIndex &index = data.fieldValueIndex;
   for (unsigned i = 0; i < data.courses.size(); i++) {
     fileObject << data.courses[i].getName() << ","
                << data.courses[i].getClassSize() << ",";
-    for (unsigned j = 0;
-         j < data.fieldValueVars[i][FieldType::instructor].size(); j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::instructor][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::instructor); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::instructor, j))) {
         fileObject << data.instructors[j].getName();
       }
     }
     fileObject << ",";
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::segment].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::segment][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::segment); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::segment, j))) {
         fileObject << data.segments[j].getName();
       }
     }
     fileObject << ",";
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::isMinor].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::isMinor][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::isMinor); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::isMinor, j))) {
         fileObject << data.isMinors[j].getName();
       }
     }
     fileObject << ",";
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::program].size();
-         j += 2) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::program][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::program); j += 2) {
+      if (isVarTrue(index.getVar(i, FieldType::program, j))) {
         fileObject << data.programs[j].getCourseTypeName() << ",";
-      } else if (isVarTrue(data.fieldValueVars[i][FieldType::program][j + 1])) {
+      } else if (isVarTrue(index.getVar(i, FieldType::program, j + 1))) {
         fileObject << data.programs[j + 1].getCourseTypeName() << ",";
       } else {
         fileObject << "No,";
       }
     }
-    for (unsigned j = 0;
-         j < data.fieldValueVars[i][FieldType::classroom].size(); j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::classroom][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::classroom); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::classroom, j))) {
         fileObject << data.classrooms[j].getName();
       }
     }
     fileObject << ",";
-    for (unsigned j = 0; j < data.fieldValueVars[i][FieldType::slot].size();
-         j++) {
-      if (isVarTrue(data.fieldValueVars[i][FieldType::slot][j])) {
+    for (unsigned j = 0; j < index.getValueCount(FieldType::slot); j++) {
+      if (isVarTrue(index.getVar(i, FieldType::slot, j))) {
         fileObject << data.slots[j].getName();
       }
     }
@@ -468,6 +1173,15 @@ void Timetabler::displayUnsatisfiedOutputReasons() {
 }
 
 /**
- * @brief      Destroys the object, and deletes the solver.
+ * @brief      Destroys the object, and deletes the solvers.
  */
-Timetabler::~Timetabler() { delete solver; }
+Timetabler::~Timetabler() {
+  delete context;
+  delete solver;
+  for (std::vector<TSolver *> &solvers : componentSolvers) {
+    for (TSolver *componentSolver : solvers) {
+      delete componentSolver;
+    }
+  }
+  delete components;
+}
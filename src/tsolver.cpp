@@ -32,9 +32,16 @@
 
 #include "tsolver.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include "algorithms/Alg_OLL.h"
 #include "mtl/Vec.h"
 #include "utils.h"
+#include "utils/System.h"
 
 using namespace NSPACE;
 using namespace openwbo;
@@ -45,7 +52,126 @@ using namespace openwbo;
  * @param[in]  verb  The verbosity value to be given to the OLL object
  * @param[in]  enc   The encoding value to be given to the OLL object
  */
-TSolver::TSolver(int verb, int enc) : OLL(verb, enc) {}
+TSolver::TSolver(int verb, int enc) : OLL(verb, enc) {
+  deadline = std::chrono::steady_clock::time_point::max();
+  interrupted = false;
+  timedOut = false;
+  stratification = true;
+  randomSeed = 0;
+  loadedFormula = NULL;
+  satCalls = 0;
+}
+
+/**
+ * @brief      Destroys the object, and deletes the loaded formula if it has
+ * been replaced by a restored one.
+ */
+TSolver::~TSolver() {
+  // the current formula is deleted by the MaxSAT object
+  if (loadedFormula != NULL && loadedFormula != maxsat_formula) {
+    delete loadedFormula;
+  }
+}
+
+/**
+ * @brief      Sets the time at which the next search is interrupted, and
+ * clears an earlier interruption.
+ *
+ * @param[in]  deadline  The deadline
+ */
+void TSolver::setDeadline(std::chrono::steady_clock::time_point deadline) {
+  std::lock_guard<std::mutex> lock(solverMutex);
+  this->deadline = deadline;
+  interrupted = false;
+  if (solver != NULL) {
+    solver->clearInterrupt();
+  }
+}
+
+/**
+ * @brief      Sets whether the soft clauses are considered in decreasing
+ * order of their weights.
+ *
+ * @param[in]  stratification  True to stratify, which is the default
+ */
+void TSolver::setStratification(bool stratification) {
+  this->stratification = stratification;
+}
+
+/**
+ * @brief      Sets the random seed of the SAT solver, which then makes some
+ * random decisions.
+ *
+ * @param[in]  randomSeed  The random seed, which must be positive
+ */
+void TSolver::setRandomSeed(double randomSeed) {
+  this->randomSeed = randomSeed;
+}
+
+/**
+ * @brief      Sets the literals that the SAT solver tries first when it makes
+ * decisions, such as the literals of a previous solution. They are applied
+ * at the start of every search, replacing the phases that the SAT solver
+ * saved in the previous search.
+ *
+ * @param[in]  phases  The literals
+ */
+void TSolver::setPhases(const std::vector<Lit> &phases) {
+  this->phases = phases;
+}
+
+/**
+ * @brief      Sets the function that is called with the progress of the
+ * search before every call of the SAT solver, and when the search returns.
+ *
+ * The function is called on the thread of the search.
+ *
+ * @param[in]  progressCallback  The function
+ */
+void TSolver::setProgressCallback(
+    std::function<void(const SolverProgress &)> progressCallback) {
+  this->progressCallback = progressCallback;
+}
+
+/**
+ * @brief      Calls the progress callback, if any, with the current progress
+ * of the search.
+ *
+ * @param[in]  finished  Whether the search has returned
+ */
+void TSolver::reportProgress(bool finished) {
+  if (!progressCallback) {
+    return;
+  }
+  SolverProgress progress;
+  progress.elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - searchStart)
+                         .count();
+  // the lower bound is meaningless if the formula is unsatisfiable
+  progress.lowerBound = (nbSatisfiable > 0) ? lbCost : 0;
+  progress.upperBound = (nbSatisfiable > 0) ? ubCost : UINT64_MAX;
+  progress.cores = nbCores;
+  progress.averageCoreSize =
+      (nbCores > 0) ? static_cast<double>(sumSizeCores) / nbCores : 0;
+  progress.minWeight = min_weight;
+  progress.satCalls = satCalls;
+  progress.memory = memUsed();
+  progress.finished = finished;
+  progressCallback(progress);
+}
+
+/**
+ * @brief      Interrupts the search, which then returns the best model found
+ * so far. This can be called from another thread, and also stops a search
+ * that has not started yet.
+ */
+void TSolver::interrupt() {
+  std::lock_guard<std::mutex> lock(solverMutex);
+  interrupted = true;
+  if (solver != NULL) {
+    solver->interrupt();
+  }
+}
 
 /**
  * @brief      Solves the MaxSAT problem by calling the solver
@@ -53,12 +179,16 @@ TSolver::TSolver(int verb, int enc) : OLL(verb, enc) {}
  * This is a modification of the search() function in the OLL algorithm of
  * Open WBO. Most of the code is identical, except that it expects the problem
  * to be weighted and returns the model found by the solver instead of exiting
- * at the end.
+ * at the end. If a deadline is set, a watchdog thread interrupts the SAT
+ * solver when it is reached.
+ *
+ * @param[in]  assumptions  The literals that are assumed to be True
  *
  * @return     The model found by the solver. This could be empty if the problem
- * was unsatisfiable
+ * was unsatisfiable under the assumptions, or if no model was found before
+ * the deadline
  */
-std::vector<lbool> TSolver::tSearch() {
+std::vector<lbool> TSolver::tSearch(const std::vector<Lit> &assumptions) {
   if (encoding != _CARD_TOTALIZER_) {
     printf(
         "Error: Currently algorithm MSU3 with iterative encoding only "
@@ -68,7 +198,37 @@ std::vector<lbool> TSolver::tSearch() {
   }
 
   if (maxsat_formula->getProblemType() == _WEIGHTED_) {
+    searchAssumptions.clear();
+    for (Lit assumption : assumptions) {
+      searchAssumptions.push(assumption);
+    }
+    bool finished = false;
+    std::condition_variable finishedCondition;
+    std::thread watchdog;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+      watchdog = std::thread([this, &finished, &finishedCondition]() {
+        std::unique_lock<std::mutex> lock(solverMutex);
+        if (!finishedCondition.wait_until(lock, deadline,
+                                          [&finished]() { return finished; })) {
+          interrupted = true;
+          if (solver != NULL) {
+            solver->interrupt();
+          }
+        }
+      });
+    }
+    searchStart = std::chrono::steady_clock::now();
+    satCalls = 0;
     tWeighted();
+    reportProgress(true);
+    if (watchdog.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(solverMutex);
+        finished = true;
+      }
+      finishedCondition.notify_one();
+      watchdog.join();
+    }
     return Utils::convertVecDataToVector<lbool>(model, model.size());
   } else {
     printf("Error: Use the solver in 'weighted' mode only!\n");
@@ -82,13 +242,49 @@ std::vector<lbool> TSolver::tSearch() {
  * This is a modification of the weighted() function in the OLL algorithm of
  * Open WBO. Most of the code is identical, except that when the result is
  * found, the function returns instead of printing the answer to stdout and
- * exiting.
+ * exiting. It also returns when it is interrupted, keeping the best model
+ * found so far.
+ *
+ * The SAT solver is only built in the first search. Later searches restore
+ * the soft clauses of the loaded formula and find the cores again, as the
+ * cores of an earlier search may depend on its assumptions. Every search
+ * starts from the phases given by setPhases().
  */
 void TSolver::tWeighted() {
   // nbInitialVariables = nVars();
   lbool res = l_True;
-  initRelaxation();
-  solver = rebuildSolver();
+  timedOut = false;
+  if (loadedFormula == NULL) {
+    initRelaxation();
+    Solver *newSolver = rebuildSolver();
+    if (randomSeed > 0) {
+      newSolver->random_seed = randomSeed;
+      newSolver->random_var_freq = RANDOM_VAR_FREQ;
+    }
+    {
+      std::lock_guard<std::mutex> lock(solverMutex);
+      solver = newSolver;
+    }
+    loadedFormula = maxsat_formula;
+    for (int i = 0; i < maxsat_formula->nSoft(); i++) {
+      softWeights.push_back(maxsat_formula->getSoftClause(i).weight);
+    }
+  } else {
+    restoreFormula();
+    coreMapping.clear();
+    boundMapping.clear();
+    activeSoft.clear();
+    model.clear();
+    lbCost = 0;
+    ubCost = UINT64_MAX;
+    nbSatisfiable = 0;
+    nbCores = 0;
+    sumSizeCores = 0;
+  }
+  for (Lit phase : phases) {
+    // a polarity of True makes the SAT solver try the negative literal
+    solver->setPolarity(var(phase), sign(phase));
+  }
 
   vec<Lit> assumptions;
   vec<Lit> joinObjFunction;
@@ -107,7 +303,23 @@ void TSolver::tWeighted() {
   // printf("current weight %d\n",maxsat_formula->getMaximumWeight());
 
   for (;;) {
-    res = searchSATSolver(solver, assumptions);
+    // the deadline may have passed before the solver could be interrupted
+    if (interrupted) {
+      timedOut = true;
+      return;
+    }
+    vec<Lit> callAssumptions;
+    searchAssumptions.copyTo(callAssumptions);
+    for (int i = 0; i < assumptions.size(); i++) {
+      callAssumptions.push(assumptions[i]);
+    }
+    reportProgress(false);
+    res = searchSATSolver(solver, callAssumptions);
+    satCalls++;
+    if (res == l_Undef) {
+      timedOut = true;
+      return;
+    }
     if (res == l_True) {
       nbSatisfiable++;
       uint64_t newCost = computeCostModel(solver->model);
@@ -124,8 +336,11 @@ void TSolver::tWeighted() {
       }
 
       if (nbSatisfiable == 1) {
+        // without stratification, all soft clauses are considered at once
         min_weight =
-            findNextWeightDiversity(min_weight, cardinality_assumptions);
+            stratification
+                ? findNextWeightDiversity(min_weight, cardinality_assumptions)
+                : 1;
         // printf("current weight %d\n",min_weight);
 
         for (int i = 0; i < maxsat_formula->nSoft(); i++)
@@ -464,7 +679,17 @@ void TSolver::tWeighted() {
       if (soft_relax.size() == 1 && cardinality_relax.size() == 0) {
         // Unit core
         // printf("UNIT CORE\n");
-        solver->addClause(soft_relax[0]);
+        // the core only holds under the assumptions of the search in it
+        vec<Lit> unitCore;
+        unitCore.push(soft_relax[0]);
+        for (int i = 0; i < solver->conflict.size(); i++) {
+          Lit p = solver->conflict[i];
+          if (coreMapping.find(p) == coreMapping.end() &&
+              boundMapping.find(p) == boundMapping.end()) {
+            unitCore.push(p);
+          }
+        }
+        solver->addClause(unitCore);
       }
 
       // assert (soft_relax.size() > 0 || cardinality_relax.size() != 1);
@@ -534,3 +759,52 @@ void TSolver::tWeighted() {
     }
   }
 }
+
+/**
+ * @brief      Replaces the formula changed by the last search with the soft
+ * clauses of the loaded formula.
+ *
+ * The hard clauses and the relaxation of the soft clauses are already in the
+ * SAT solver. The soft clauses and cardinality constraints that the last
+ * search added only remain in the SAT solver, where they are not assumed.
+ */
+void TSolver::restoreFormula() {
+  MaxSATFormula *restored = new MaxSATFormula();
+  restored->setProblemType(loadedFormula->getProblemType());
+  while (restored->nVars() < solver->nVars()) {
+    restored->newVar();
+  }
+  restored->setInitialVars(loadedFormula->nInitialVars());
+  restored->setMaximumWeight(loadedFormula->getMaximumWeight());
+  for (unsigned i = 0; i < softWeights.size(); i++) {
+    Soft &soft = loadedFormula->getSoftClause(i);
+    vec<Lit> clause;
+    vec<Lit> vars;
+    soft.clause.copyTo(clause);
+    soft.relaxation_vars.copyTo(vars);
+    restored->addSoftClause(softWeights[i], clause, vars);
+    restored->getSoftClause(i).assumption_var = soft.assumption_var;
+  }
+  if (maxsat_formula != loadedFormula) {
+    delete maxsat_formula;
+  }
+  maxsat_formula = restored;
+}
+
+/**
+ * @brief      Checks if the last search was interrupted at the deadline
+ * before it finished.
+ *
+ * If it was not, the model is optimal, or the problem is unsatisfiable.
+ *
+ * @return     True if the search was interrupted, False otherwise
+ */
+bool TSolver::hasTimedOut() { return timedOut; }
+
+/**
+ * @brief      Gets the cost of the best model found by the last search.
+ *
+ * @return     The sum of the weights of the soft clauses falsified by the
+ * model
+ */
+uint64_t TSolver::getCost() { return ubCost; }
@@ -1,24 +1,37 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <vector>
 #include "cclause.h"
+#include "clause_sink.h"
 #include "clauses.h"
+#include "encoding_context.h"
 #include "global.h"
-#include "timetabler.h"
+
+class RecordingClauseSink : public ClauseSink {
+ public:
+  std::vector<std::vector<Lit>> clauses;
+  void addClause(const Lit *lits, unsigned size, int64_t weight) {
+    clauses.push_back(std::vector<Lit>(lits, lits + size));
+  }
+};
 
 class TestClauses : public ::testing::Test {
  public:
   Lit lit[6];
   Clauses clauseG1, clauseG2;
+  RecordingClauseSink *sink;
+  EncodingContext *context;
   TestClauses() {}
   void SetUp();
-  void TearDown() {}
+  void TearDown() { delete context; }
   void printClause(Clauses);
 };
 
 void TestClauses::SetUp() {
-  Timetabler *timetabler = new Timetabler();
+  sink = new RecordingClauseSink();
+  context = new EncodingContext(sink);
   for (int i = 0; i < 6; i++) {
-    lit[i] = timetabler->newLiteral(false);
+    lit[i] = context->newLiteral(false);
   }
   std::vector<CClause> clauses1;
   std::vector<CClause> clauses2;
@@ -29,14 +42,14 @@ void TestClauses::SetUp() {
   temp.clear();
   temp.addLits(lit[2], ~lit[3], lit[4]);
   clauses1.push_back(temp);
-  clauseG1 = Clauses(clauses1);
+  clauseG1 = Clauses(clauses1, context);
   temp.clear();
   temp.addLits(~lit[0], lit[5], lit[3]);
   clauses2.push_back(temp);
   temp.clear();
   temp.addLits(lit[1], ~lit[2], ~lit[3]);
   clauses2.push_back(temp);
-  clauseG2 = Clauses(clauses2);
+  clauseG2 = Clauses(clauses2, context);
 }
 
 void TestClauses::printClause(Clauses input) {
@@ -55,32 +68,28 @@ void TestClauses::printClause(Clauses input) {
   std::cout << "Done" << std::endl;
 }
 
-// Disabled because this need Timetabler and it fails (TODO)
-/*TEST_F(TestClauses, ORTestNormal) {
-    Clauses result = clauseG1 | clauseG2;
+TEST_F(TestClauses, ORTestNormal) {
+  Clauses result = clauseG1 | clauseG2;
+  ASSERT_EQ(result.size(), 1);
+  ClauseView clause = result.getClause(0);
+  ASSERT_EQ(clause.size(), 2);
+  ASSERT_EQ(sink->clauses.size(), 0);
 
-    std::vector<CClause> resultClauses = result.getClauses();
-    ASSERT_EQ(resultClauses.size(), 4);
+  // the result needs one direction of the definitions of both sets of clauses
+  context->addClause(clause.begin(), clause.size(), -1);
+  ASSERT_EQ(sink->clauses.size(), 9);
 
-    ASSERT_EQ(resultClauses[0].getLits().size(), 2);
-    ASSERT_EQ(resultClauses[1].getLits().size(), 4);
-    ASSERT_EQ(resultClauses[2].getLits().size(), 2);
-    ASSERT_EQ(resultClauses[3].getLits().size(), 2);
+  ASSERT_EQ(sink->clauses[0].size(), 3);
+  ASSERT_EQ(sink->clauses[0][0], lit[0]);
+  ASSERT_EQ(sink->clauses[0][1], lit[1]);
 
-    ASSERT_EQ(resultClauses[0].getLits()[0], lit[0]);
-    ASSERT_EQ(resultClauses[0].getLits()[1], ~lit[0]);
+  ASSERT_EQ(sink->clauses[1].size(), 4);
+  ASSERT_EQ(sink->clauses[1][0], lit[2]);
+  ASSERT_EQ(sink->clauses[1][1], ~lit[3]);
+  ASSERT_EQ(sink->clauses[1][2], lit[4]);
 
-    ASSERT_EQ(resultClauses[1].getLits()[0], lit[0]);
-    ASSERT_EQ(resultClauses[1].getLits()[1], lit[1]);
-    ASSERT_EQ(resultClauses[1].getLits()[2], ~lit[2]);
-    ASSERT_EQ(resultClauses[1].getLits()[3], ~lit[3]);
-
-    ASSERT_EQ(resultClauses[2].getLits()[0], lit[3]);
-    ASSERT_EQ(resultClauses[2].getLits()[1], ~lit[3]);
-
-    ASSERT_EQ(resultClauses[3].getLits()[0], lit[2]);
-    ASSERT_EQ(resultClauses[3].getLits()[1], ~lit[2]);
-}*/
+  ASSERT_EQ(sink->clauses[8], std::vector<Lit>(clause.begin(), clause.end()));
+}
 
 TEST_F(TestClauses, ORTestRHSEmpty) {
   Clauses clause;
@@ -90,6 +99,28 @@ TEST_F(TestClauses, ORTestRHSEmpty) {
   ASSERT_EQ(resultClauses.size(), 0);
 }
 
+TEST_F(TestClauses, ORTestUnits) {
+  Clauses result = Clauses(lit[0], context) | Clauses(~lit[1], context);
+  ASSERT_EQ(result.size(), 1);
+
+  ClauseView clause = result.getClause(0);
+  ASSERT_EQ(clause.size(), 2);
+  ASSERT_EQ(clause[0], lit[0]);
+  ASSERT_EQ(clause[1], ~lit[1]);
+}
+
+TEST_F(TestClauses, ORTestSharedDefinitions) {
+  Clauses result = clauseG1 | clauseG2;
+  Clauses repeated = clauseG1 | clauseG2;
+  ASSERT_EQ(result.size(), 1);
+  ASSERT_EQ(repeated.size(), 1);
+
+  ASSERT_EQ(result.getClause(0).size(), 2);
+  ASSERT_EQ(repeated.getClause(0).size(), 2);
+  ASSERT_EQ(result.getClause(0)[0], repeated.getClause(0)[0]);
+  ASSERT_EQ(result.getClause(0)[1], repeated.getClause(0)[1]);
+}
+
 TEST_F(TestClauses, ANDTestNormal) {
   Clauses result = clauseG1 & clauseG2;
   std::vector<CClause> resultClauses = result.getClauses();
@@ -125,29 +156,72 @@ TEST_F(TestClauses, ANDTestRHSEmpty) {
   ASSERT_EQ(resultClauses[1].getLits()[2], lit[4]);
 }
 
-// Disabled because this need Timetabler and it fails (TODO)
-/*TEST_F(TestClauses, NOTTestNormal) {
-    Clauses result = ~clauseG1;
-    std::vector<CClause> resultClauses = result.getClauses();
-    ASSERT_EQ(resultClauses.size(), 6);
-    for (int i = 0; i <= 5; i++) {
-        ASSERT_EQ(resultClauses[i].getLits().size(), 2);
-    }
+TEST_F(TestClauses, ClauseViewTest) {
+  Clauses result = clauseG1 & clauseG2;
+  ASSERT_EQ(result.size(), 4);
+
+  ClauseView clause = result.getClause(1);
+  ASSERT_EQ(clause.size(), 3);
+  ASSERT_EQ(clause[0], lit[2]);
+  ASSERT_EQ(clause[1], ~lit[3]);
+  ASSERT_EQ(clause[2], lit[4]);
+
+  result.addClauses(result);
+  ASSERT_EQ(result.size(), 8);
+  clause = result.getClause(6);
+  ASSERT_EQ(clause.size(), 3);
+  ASSERT_EQ(clause[0], ~lit[0]);
+
+  result.clear();
+  ASSERT_EQ(result.size(), 0);
+}
+
+TEST_F(TestClauses, NOTTestNormal) {
+  Clauses result = ~clauseG1;
+  ASSERT_EQ(result.size(), 1);
+  ClauseView clause = result.getClause(0);
+  ASSERT_EQ(clause.size(), 2);
 
-    ASSERT_EQ(resultClauses[0].getLits()[0], ~lit[0]);
-    ASSERT_EQ(resultClauses[1].getLits()[0], ~lit[0]);
-    ASSERT_EQ(resultClauses[2].getLits()[0], ~lit[0]);
-    ASSERT_EQ(resultClauses[3].getLits()[0], ~lit[1]);
-    ASSERT_EQ(resultClauses[4].getLits()[0], ~lit[1]);
-    ASSERT_EQ(resultClauses[5].getLits()[0], ~lit[1]);
-
-    ASSERT_EQ(resultClauses[0].getLits()[1], ~lit[2]);
-    ASSERT_EQ(resultClauses[1].getLits()[1], lit[3]);
-    ASSERT_EQ(resultClauses[2].getLits()[1], ~lit[4]);
-    ASSERT_EQ(resultClauses[3].getLits()[1], ~lit[2]);
-    ASSERT_EQ(resultClauses[4].getLits()[1], lit[3]);
-    ASSERT_EQ(resultClauses[5].getLits()[1], ~lit[4]);
-}*/
+  context->addClause(clause.begin(), clause.size(), -1);
+  ASSERT_EQ(sink->clauses.size(), 6);
+  for (int i = 0; i <= 5; i++) {
+    ASSERT_EQ(sink->clauses[i].size(), 2);
+  }
+
+  ASSERT_EQ(sink->clauses[0][0], ~clause[0]);
+  ASSERT_EQ(sink->clauses[1][0], ~clause[0]);
+  ASSERT_EQ(sink->clauses[2][0], ~clause[1]);
+  ASSERT_EQ(sink->clauses[3][0], ~clause[1]);
+  ASSERT_EQ(sink->clauses[4][0], ~clause[1]);
+
+  ASSERT_EQ(sink->clauses[0][1], ~lit[0]);
+  ASSERT_EQ(sink->clauses[1][1], ~lit[1]);
+  ASSERT_EQ(sink->clauses[2][1], ~lit[2]);
+  ASSERT_EQ(sink->clauses[3][1], lit[3]);
+  ASSERT_EQ(sink->clauses[4][1], ~lit[4]);
+}
+
+TEST_F(TestClauses, NOTTestDefinitions) {
+  Clauses result = ~clauseG1;
+  ASSERT_EQ(result.size(), 1);
+  ASSERT_EQ(result.getClause(0).size(), 2);
+
+  Clauses repeated = ~clauseG1;
+  ASSERT_EQ(result.getClause(0)[0], repeated.getClause(0)[0]);
+  ASSERT_EQ(result.getClause(0)[1], repeated.getClause(0)[1]);
+}
+
+TEST_F(TestClauses, NOTTestSingleClause) {
+  CClause clause;
+  clause.addLits(lit[0], ~lit[1]);
+  Clauses result = ~Clauses(clause);
+  ASSERT_EQ(result.size(), 2);
+
+  ASSERT_EQ(result.getClause(0).size(), 1);
+  ASSERT_EQ(result.getClause(1).size(), 1);
+  ASSERT_EQ(result.getClause(0)[0], ~lit[0]);
+  ASSERT_EQ(result.getClause(1)[0], lit[1]);
+}
 
 TEST_F(TestClauses, NOTTestEmpty) {
   Clauses clauses;
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include "clause_sink.h"
+#include "constraint_encoder.h"
+#include "global.h"
+#include "timetabler.h"
+
+class TestConstraintEncoder : public ::testing::Test {
+ public:
+  Timetabler timetabler;
+  BufferClauseSink *sink;
+  std::vector<Lit> lits;
+  void SetUp();
+  void addLits(unsigned);
+  bool isSatisfiable(unsigned);
+  void checkAtMostK(unsigned, unsigned);
+};
+
+void TestConstraintEncoder::SetUp() {
+  sink = new BufferClauseSink();
+  timetabler.setClauseSink(sink);
+}
+
+void TestConstraintEncoder::addLits(unsigned n) {
+  for (unsigned i = 0; i < n; i++) {
+    lits.push_back(mkLit(timetabler.newVar(), false));
+  }
+}
+
+/**
+ * Checks whether the clauses in the sink are satisfiable when the i-th of the
+ * literals is True exactly if the i-th bit of the mask is set.
+ *
+ * Once the literals are fixed, the encodings of atMostK are Horn clauses over
+ * the auxiliary variables, so they are satisfiable exactly if their least
+ * model, found by forward chaining, satisfies them.
+ */
+bool TestConstraintEncoder::isSatisfiable(unsigned mask) {
+  std::vector<bool> value(timetabler.getEncodingContext()->nVars(), false);
+  for (unsigned i = 0; i < lits.size(); i++) {
+    value[var(lits[i])] = (mask >> i) & 1;
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (unsigned c = 0; c < sink->size(); c++) {
+      const Lit *clause = sink->getClause(c);
+      bool satisfied = false;
+      int implied = -1;
+      for (unsigned j = 0; j < sink->getClauseSize(c); j++) {
+        if (value[var(clause[j])] != sign(clause[j])) {
+          satisfied = true;
+        } else if (!sign(clause[j])) {
+          implied = var(clause[j]);
+        }
+      }
+      if (!satisfied && implied >= static_cast<int>(lits.size())) {
+        value[implied] = true;
+        changed = true;
+      }
+    }
+  }
+  for (unsigned c = 0; c < sink->size(); c++) {
+    const Lit *clause = sink->getClause(c);
+    bool satisfied = false;
+    for (unsigned j = 0; j < sink->getClauseSize(c); j++) {
+      if (value[var(clause[j])] != sign(clause[j])) {
+        satisfied = true;
+      }
+    }
+    if (!satisfied) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TestConstraintEncoder::checkAtMostK(unsigned n, unsigned k) {
+  addLits(n);
+  ConstraintEncoder encoder(&timetabler, timetabler.getEncodingContext());
+  timetabler.addClauses(encoder.atMostK(lits, k), -1);
+  for (unsigned mask = 0; mask < (1u << n); mask++) {
+    unsigned count = __builtin_popcount(mask);
+    ASSERT_EQ(isSatisfiable(mask), count <= k) << "mask " << mask;
+  }
+}
+
+TEST_F(TestConstraintEncoder, AtMostZero) {
+  checkAtMostK(5, 0);
+  ASSERT_EQ(sink->size(), 5);
+}
+
+TEST_F(TestConstraintEncoder, AtMostOneBinomial) {
+  timetabler.data.amoEncoding = AMOEncoding::binomial;
+  checkAtMostK(5, 1);
+}
+
+TEST_F(TestConstraintEncoder, AtMostOneSequential) {
+  timetabler.data.amoEncoding = AMOEncoding::sequential;
+  checkAtMostK(5, 1);
+}
+
+TEST_F(TestConstraintEncoder, AtMostOneProduct) {
+  timetabler.data.amoEncoding = AMOEncoding::product;
+  checkAtMostK(7, 1);
+}
+
+TEST_F(TestConstraintEncoder, AtMostKTotalizer) {
+  checkAtMostK(7, 3);
+}
+
+TEST_F(TestConstraintEncoder, AtMostKNotLimiting) {
+  checkAtMostK(5, 5);
+  ASSERT_EQ(sink->size(), 0);
+  lits.clear();
+  checkAtMostK(3, 4);
+  ASSERT_EQ(sink->size(), 0);
+}
+
+TEST_F(TestConstraintEncoder, AddCardinality) {
+  addLits(4);
+  Var selector = timetabler.newVar();
+  timetabler.addCardinality(lits, 1, selector, 0);
+  ASSERT_EQ(sink->size(), 0);
+  // a soft constraint is guarded by its selector variable
+  timetabler.addCardinality(lits, 2, selector, 1);
+  unsigned softCount = sink->size();
+  ASSERT_GT(softCount, 0);
+  for (unsigned c = 0; c < softCount; c++) {
+    const Lit *clause = sink->getClause(c);
+    unsigned size = sink->getClauseSize(c);
+    ASSERT_EQ(sink->getWeight(c), -1);
+    ASSERT_NE(std::find(clause, clause + size, mkLit(selector, true)),
+              clause + size);
+  }
+  // a hard constraint is added as it is
+  timetabler.data.directHardConstraints = true;
+  timetabler.addCardinality(lits, 2, selector, -1);
+  ASSERT_EQ(sink->size(), 2 * softCount);
+  for (unsigned c = softCount; c < sink->size(); c++) {
+    const Lit *clause = sink->getClause(c);
+    unsigned size = sink->getClauseSize(c);
+    ASSERT_EQ(std::find(clause, clause + size, mkLit(selector, true)),
+              clause + size);
+  }
+}
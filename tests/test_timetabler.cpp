@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "global.h"
+#include "timetabler.h"
+
+class TestTimetabler : public ::testing::Test {
+ public:
+  static const unsigned VAR_COUNT = 12;
+  std::vector<std::vector<Lit>> hardClauses;
+  std::vector<std::pair<std::vector<Lit>, int>> softClauses;
+  void SetUp();
+  void encode(Timetabler &, bool);
+  bool getOptimum(const std::vector<Lit> &, uint64_t &);
+  void checkSolve(Timetabler &, const std::vector<Lit> &, bool);
+  void checkSession(bool);
+};
+
+/**
+ * Makes a formula whose first and second halves of the variables are in
+ * separate clauses, so that a buffered formula has two components.
+ */
+void TestTimetabler::SetUp() {
+  unsigned seed = 7;
+  auto random = [&seed](unsigned limit) {
+    seed = seed * 1103515245 + 12345;
+    return (seed / 65536) % limit;
+  };
+  unsigned half = VAR_COUNT / 2;
+  for (unsigned i = 0; i < 16; i++) {
+    unsigned offset = (i % 2) * half;
+    std::vector<Lit> clause;
+    for (unsigned j = 0; j < 3; j++) {
+      clause.push_back(mkLit(offset + random(half), random(2)));
+    }
+    hardClauses.push_back(clause);
+  }
+  const int weights[] = {1, 2, 3, 5};
+  for (unsigned i = 0; i < 16; i++) {
+    unsigned offset = (i % 2) * half;
+    std::vector<Lit> clause(1, mkLit(offset + random(half), random(2)));
+    if (i % 3 == 0) {
+      clause.push_back(mkLit(offset + random(half), random(2)));
+    }
+    softClauses.push_back(std::make_pair(clause, weights[random(4)]));
+  }
+}
+
+void TestTimetabler::encode(Timetabler &timetabler, bool buffered) {
+  if (buffered) {
+    timetabler.bufferClauses();
+    timetabler.data.portfolio.assign(
+        {SolverConfiguration::stratified, SolverConfiguration::unstratified});
+  }
+  for (unsigned i = 0; i < VAR_COUNT; i++) {
+    timetabler.newVar();
+  }
+  for (std::vector<Lit> &clause : hardClauses) {
+    timetabler.addToFormula(clause.data(), clause.size(), -1);
+  }
+  for (std::pair<std::vector<Lit>, int> &clause : softClauses) {
+    timetabler.addToFormula(clause.first.data(), clause.first.size(),
+                            clause.second);
+  }
+}
+
+/**
+ * Finds the optimum cost under the assumptions by trying every assignment,
+ * and returns False if there is no assignment that satisfies the hard
+ * clauses and the assumptions.
+ */
+bool TestTimetabler::getOptimum(const std::vector<Lit> &assumptions,
+                                uint64_t &optimum) {
+  auto isTrue = [](unsigned mask, Lit lit) {
+    return (((mask >> var(lit)) & 1) != 0) != sign(lit);
+  };
+  auto isSatisfied = [&isTrue](unsigned mask, const std::vector<Lit> &clause) {
+    for (Lit lit : clause) {
+      if (isTrue(mask, lit)) {
+        return true;
+      }
+    }
+    return false;
+  };
+  bool found = false;
+  for (unsigned mask = 0; mask < (1u << VAR_COUNT); mask++) {
+    bool satisfied = true;
+    for (Lit lit : assumptions) {
+      satisfied = satisfied && isTrue(mask, lit);
+    }
+    for (std::vector<Lit> &clause : hardClauses) {
+      satisfied = satisfied && isSatisfied(mask, clause);
+    }
+    if (!satisfied) {
+      continue;
+    }
+    uint64_t cost = 0;
+    for (std::pair<std::vector<Lit>, int> &clause : softClauses) {
+      if (!isSatisfied(mask, clause.first)) {
+        cost += clause.second;
+      }
+    }
+    if (!found || cost < optimum) {
+      optimum = cost;
+    }
+    found = true;
+  }
+  return found;
+}
+
+/**
+ * Solves the session under its current assumptions, and compares the result
+ * with the optimum and with a new Timetabler in which the assumptions are
+ * hard unit clauses.
+ */
+void TestTimetabler::checkSolve(Timetabler &session,
+                                const std::vector<Lit> &assumptions,
+                                bool buffered) {
+  uint64_t optimum = 0;
+  bool satisfiable = getOptimum(assumptions, optimum);
+  SolverStatus status = session.solve();
+  Timetabler fresh;
+  encode(fresh, buffered);
+  for (Lit lit : assumptions) {
+    fresh.addToFormula(lit, -1);
+  }
+  SolverStatus freshStatus = fresh.solve();
+  if (!satisfiable) {
+    ASSERT_EQ(status, SolverStatus::Unsolved);
+    ASSERT_EQ(freshStatus, SolverStatus::Unsolved);
+    return;
+  }
+  ASSERT_EQ(status, SolverStatus::Solved);
+  ASSERT_EQ(freshStatus, SolverStatus::Solved);
+  ASSERT_TRUE(session.isOptimal());
+  ASSERT_EQ(session.getCost(), optimum);
+  ASSERT_EQ(fresh.getCost(), optimum);
+  for (Lit lit : assumptions) {
+    ASSERT_EQ(session.isVarTrue(var(lit)), !sign(lit));
+  }
+}
+
+void TestTimetabler::checkSession(bool buffered) {
+  Timetabler session;
+  session.data.session = true;
+  encode(session, buffered);
+  uint64_t optimum;
+  ASSERT_TRUE(getOptimum(std::vector<Lit>(), optimum));
+  checkSolve(session, {}, buffered);
+  // assume literals in both components, against the soft clauses
+  std::vector<Lit> assumed;
+  for (unsigned i = 0; i < softClauses.size() && assumed.size() < 2; i++) {
+    Lit lit = ~softClauses[i].first[0];
+    if (var(lit) >= static_cast<int>(VAR_COUNT / 2) || i % 2 == 0) {
+      assumed.push_back(lit);
+    }
+  }
+  session.assume(assumed[0]);
+  checkSolve(session, {assumed[0]}, buffered);
+  session.assume(assumed[1]);
+  checkSolve(session, {assumed[0], assumed[1]}, buffered);
+  // replacing an assumption on the same variable
+  session.assume(~assumed[1]);
+  checkSolve(session, {assumed[0], ~assumed[1]}, buffered);
+  session.retract(var(assumed[0]));
+  checkSolve(session, {~assumed[1]}, buffered);
+  session.clearAssumptions();
+  checkSolve(session, {}, buffered);
+  // every assignment of a few variables, some of which are unsatisfiable
+  for (unsigned mask = 0; mask < 16; mask++) {
+    std::vector<Lit> lits;
+    for (unsigned i = 0; i < 4; i++) {
+      lits.push_back(mkLit(i * 3, (mask >> i) & 1));
+      session.assume(lits.back());
+    }
+    checkSolve(session, lits, buffered);
+  }
+  session.clearAssumptions();
+  checkSolve(session, {}, buffered);
+}
+
+TEST_F(TestTimetabler, SessionMatchesFreshSolves) { checkSession(false); }
+
+TEST_F(TestTimetabler, BufferedSessionMatchesFreshSolves) {
+  checkSession(true);
+}